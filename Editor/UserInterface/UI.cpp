@@ -8,6 +8,8 @@
 
 #include <spdlog/spdlog.h>
 #include <cassert>
+#include <cfloat>
+#include <cstdio>
 namespace willeditor
 {
     EntityEditorState UI::g_entityEditor;
@@ -52,6 +54,8 @@ namespace willeditor
         ShowEntitiesList(&showHierarchyWindow);
         ShowInspectorWindow(&showInspectorWindow);
         ShowEntityCreatorWindow(&showEntityCreatorWindow);
+        ShowScriptProfilerWindow(&showScriptProfilerWindow);
+        ShowStatsWindow(&showStatsWindow);
 
         ImGui::Render();
     }
@@ -627,9 +631,175 @@ namespace willeditor
                 if (app->eventHandler->OnStopClicked) app->eventHandler->OnStopClicked();
             }
             ImGui::EndDisabled();
+
+            // Stats and profiler toggles on the right
+            ImGui::SameLine(viewport->Size.x - 180.0f);
+            if (ImGui::Button("Stats", ImVec2(80, 25)))
+            {
+                showStatsWindow = !showStatsWindow;
+            }
+            ImGui::SameLine(viewport->Size.x - 90.0f);
+            if (ImGui::Button("Profiler", ImVec2(80, 25)))
+            {
+                showScriptProfilerWindow = !showScriptProfilerWindow;
+            }
         }
         ImGui::End();
 
         ImGui::PopStyleVar(3);
     }
-}
\ No newline at end of file
+
+    void UI::ShowScriptProfilerWindow(bool* open)
+    {
+        if (!*open) return;
+
+        ImGui::SetNextWindowSize(ImVec2(460, 420), ImGuiCond_FirstUseEver);
+        if (!ImGui::Begin("Script Profiler", open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        ImGui::Checkbox("Profile scripts", &scriptProfiling);
+        ImGui::SameLine();
+        ImGui::Checkbox("Sample lines", &scriptLineSampling);
+
+        // Last frame, slowest first
+        ImGui::SeparatorText("Last frame");
+        if (ImGui::BeginTable("##ScriptProfile", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingStretchProp))
+        {
+            ImGui::TableSetupColumn("Script");
+            ImGui::TableSetupColumn("Function");
+            ImGui::TableSetupColumn("Calls");
+            ImGui::TableSetupColumn("ms");
+            ImGui::TableSetupColumn("Alloc (KB)");
+            ImGui::TableHeadersRow();
+
+            for (const willengine::ScriptProfileEntry& entry : scriptProfile)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(entry.script.c_str());
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(entry.function.c_str());
+                ImGui::TableNextColumn(); ImGui::Text("%u", entry.calls);
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", entry.milliseconds);
+                ImGui::TableNextColumn(); ImGui::Text("%.1f", entry.bytesAllocated / 1024.0);
+            }
+            ImGui::EndTable();
+        }
+        if (!scriptProfiling)
+        {
+            ImGui::TextDisabled("Profiling is off.");
+        }
+
+        // Lua garbage collector
+        ImGui::SeparatorText("Garbage collector");
+        ImGui::Text("Heap: %.1f MB", scriptGC.heapKB / 1024.0);
+        ImGui::Text("Last frame: %.3f ms in %u steps (worst %.3f ms)", scriptGC.lastFrameMs, scriptGC.stepsLastFrame, scriptGC.maxFrameMs);
+        ImGui::Text("Cycles: %u (%u over budget)", scriptGC.cyclesCompleted, scriptGC.forcedCycles);
+
+        // Hottest lines since sampling started
+        ImGui::SeparatorText("Hot lines");
+        if (scriptLines.empty())
+        {
+            ImGui::TextDisabled(scriptLineSampling ? "No samples yet." : "Line sampling is off.");
+        }
+        for (const willengine::ScriptLineSample& line : scriptLines)
+        {
+            ImGui::Text("%6u  %s", line.samples, line.location.c_str());
+        }
+
+        ImGui::End();
+    }
+
+    void UI::ShowStatsWindow(bool* open)
+    {
+        if (!*open) return;
+
+        ImGui::SetNextWindowSize(ImVec2(420, 640), ImGuiCond_FirstUseEver);
+        if (!ImGui::Begin("Engine Stats", open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        const willengine::FrameStats& stats = frameStats;
+
+        // Frame time
+        ImGui::SeparatorText("Frame");
+        ImGui::Text("%.2f ms (%.0f fps), %u ticks", stats.frameMs, stats.frameMs > 0.0 ? 1000.0 / stats.frameMs : 0.0, stats.ticks);
+        ImGui::Text("p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms", stats.p50Ms, stats.p95Ms, stats.p99Ms, stats.maxMs);
+        if (frameTimes.count > 0)
+        {
+            ImGui::PlotLines("##FrameTimes", frameTimes.values, int(frameTimes.count), int(frameTimes.oldest), "frame ms", 0.0f, float(stats.maxMs) * 1.1f, ImVec2(-1, 60));
+        }
+        if (!frameTimeHistogram.empty())
+        {
+            char label[64];
+            snprintf(label, sizeof(label), "0 - %.1f+ ms", (frameTimeHistogram.size() - 1) * willengine::Metrics::kHistogramBucketMs);
+            ImGui::PlotHistogram("##FrameTimeHistogram", frameTimeHistogram.data(), int(frameTimeHistogram.size()), 0, label, 0.0f, FLT_MAX, ImVec2(-1, 60));
+        }
+
+        // Where the frame went, ticks summed
+        ImGui::SeparatorText("Systems");
+        if (ImGui::BeginTable("##Systems", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingStretchProp))
+        {
+            ImGui::TableSetupColumn("Stage");
+            ImGui::TableSetupColumn("ms");
+            ImGui::TableHeadersRow();
+
+            const std::pair<const char*, double> stages[] = {
+                { "Input", stats.systems.input },
+                { "Scripts", stats.systems.scripts },
+                { "Game callback", stats.systems.callback },
+                { "Physics", stats.systems.physics },
+                { "Collision events", stats.systems.collisionEvents },
+                { "Draw", stats.drawMs },
+                { "Lua GC", stats.luaGCMs },
+            };
+            for (const auto& [stage, milliseconds] : stages)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(stage);
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", milliseconds);
+            }
+            ImGui::EndTable();
+        }
+
+        // Renderer and asset memory
+        ImGui::SeparatorText("Renderer");
+        ImGui::Text("Sprites: %u, draw calls: %u", stats.sprites, stats.drawCalls);
+        ImGui::Text("Instance upload: %.1f KB", stats.instanceBytesUploaded / 1024.0);
+        ImGui::Text("Textures: %zu (%.1f MB)", stats.textureCount, stats.textureBytes / (1024.0 * 1024.0));
+        ImGui::Text("Sounds: %zu (%.1f MB)", stats.soundCount, stats.soundBytes / (1024.0 * 1024.0));
+        ImGui::Text("Frame arena: %.1f / %.1f KB (%zu heap blocks)", stats.frameArenaBytes / 1024.0, stats.frameArenaCapacity / 1024.0, stats.frameArenaHeapAllocations);
+
+        // Entities per component pool
+        ImGui::SeparatorText("Components");
+        if (ImGui::BeginTable("##Pools", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingStretchProp))
+        {
+            ImGui::TableSetupColumn("Component");
+            ImGui::TableSetupColumn("Entities");
+            ImGui::TableHeadersRow();
+
+            for (const willengine::ComponentPoolCount& pool : stats.pools)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(pool.component);
+                ImGui::TableNextColumn(); ImGui::Text("%zu", pool.count);
+            }
+            ImGui::EndTable();
+        }
+
+        // Whatever the game reports through Metrics::SetCounter
+        if (!counters.empty())
+        {
+            ImGui::SeparatorText("Counters");
+            for (const auto& [name, value] : counters)
+            {
+                ImGui::Text("%s: %g", name.c_str(), value);
+            }
+        }
+
+        ImGui::End();
+    }
+}
@@ -5,6 +5,8 @@
 #include <functional>                    
 #include <Events/CreateEntityEvent.h>
 #include <Events/SaveSceneEvent.h>
+#include <ScriptManager/ScriptProfile.h>
+#include <Metrics/Metrics.h>
 #include "../States.h"
 #include "../App.h"
 namespace willeditor
@@ -65,6 +67,8 @@ namespace willeditor
 		void ShowEntityCreatorWindow(bool* open);
 		void ShowEntitiesList(bool* open);
 		void ShowInspectorWindow(bool* open);
+		void ShowScriptProfilerWindow(bool* open);
+		void ShowStatsWindow(bool* open);
 
 		PlayState GetPlayState() const { return playState; }
 		void SetPlayState(PlayState state) { playState = state; }
@@ -74,6 +78,24 @@ namespace willeditor
 		}
 
 		const std::string& GetSelectedEntity() const { return selectedEntityName; }
+
+		// Script profiler panel: the toggles are read back by the editor loop, the data is pushed in every frame.
+		bool ScriptProfilingEnabled() const { return scriptProfiling; }
+		bool ScriptLineSamplingEnabled() const { return scriptLineSampling; }
+		void SetScriptProfile(const std::vector<willengine::ScriptProfileEntry>& profile, const std::vector<willengine::ScriptLineSample>& lines) {
+			scriptProfile = profile;
+			scriptLines = lines;
+		}
+		void SetScriptGCStats(const willengine::ScriptGCStats& stats) { scriptGC = stats; }
+
+		// Stats panel: the engine's frame metrics, pushed in every frame. Copies reuse the members' storage,
+		// the frame times aren't copied at all.
+		void SetFrameStats(const willengine::Metrics& metrics) {
+			frameStats = metrics.GetFrameStats();
+			frameTimes = metrics.GetFrameTimes();
+			frameTimeHistogram = metrics.GetFrameTimeHistogram();
+			counters = metrics.GetCounters();
+		}
 	private:
 		App* app;
 		static willeditor::EntityEditorState g_entityEditor;
@@ -87,6 +109,21 @@ namespace willeditor
 
 
 		std::vector<EntityDisplayInfo> entities;
+
+		// For script profiler window
+		bool showScriptProfilerWindow = false;
+		bool scriptProfiling = false;
+		bool scriptLineSampling = false;
+		std::vector<willengine::ScriptProfileEntry> scriptProfile;
+		std::vector<willengine::ScriptLineSample> scriptLines;
+		willengine::ScriptGCStats scriptGC;
+
+		// For stats window
+		bool showStatsWindow = false;
+		willengine::FrameStats frameStats;
+		willengine::Metrics::FrameTimeRing frameTimes;	// points into the engine's Metrics
+		std::vector<float> frameTimeHistogram;
+		std::vector<std::pair<std::string, double>> counters;
 	};
 
 }
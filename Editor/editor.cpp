@@ -14,7 +14,7 @@
 
 int main(int argc, const char* argv[])
 {
-    willengine::Engine engine{ willengine::Engine::Config{.window_name = "WillEditor"}};
+    willengine::Engine engine{ willengine::Engine::Config{.window_name = "WillEditor", .hot_reload = true}};
 
     willeditor::App app;
     app.Startup(engine.graphics->GetWindow(), engine.graphics->GetDevice(), engine.graphics->GetSurfaceFormat());
@@ -79,11 +79,24 @@ int main(int argc, const char* argv[])
     engine.RunEditorLoop(
         [&]()
         {
-            // Update physics/scripts only when playing
+            // Script profiler and stats panels: apply the toggles and hand them the last frame's numbers
+            if (engine.script->IsProfilingEnabled() != app.ui->ScriptProfilingEnabled())
+                engine.script->SetProfilingEnabled(app.ui->ScriptProfilingEnabled());
+            if (engine.script->IsLineSampling() != app.ui->ScriptLineSamplingEnabled())
+                engine.script->SetLineSampling(app.ui->ScriptLineSamplingEnabled());
+            app.ui->SetScriptProfile(engine.script->GetFrameProfile(), engine.script->GetLineSamples());
+            app.ui->SetScriptGCStats(engine.script->GetGCStats());
+            app.ui->SetFrameStats(*engine.metrics);
+
+            // Update physics/scripts only when playing, at the same fixed tick rate as the game.
+            // Input is already polled once per editor frame.
             if (app.ui->GetPlayState() == willeditor::PlayState::Playing)
             {
-                engine.script->UpdateAllEntityScripts();
-                engine.physics->Update();
+                engine.AdvanceSimulation([]() {}, false);
+            }
+            else
+            {
+                engine.ResetSimulationClock();
             }
 
             // Only rebuild entity list when something changed
@@ -1,8 +1,23 @@
 function Start(self)
-    self.rb = ECS.GetRigidbody(self.entity)
+    self.speed = 40 -- world units per second
+    self.turnTimer = 0
     print("Enemy started for entity: " .. self.entity)
 end
 
-function Update(self)
-   
-end
\ No newline at end of file
+-- Batched update: called once per tick with every enemy instance,
+-- instead of calling Update(self) for each enemy.
+function UpdateAll(instances)
+    local dt = Time.DeltaTime()
+    for i = 1, #instances do
+        local self = instances[i]
+        self.turnTimer = self.turnTimer - dt
+        if self.turnTimer <= 0 then
+            -- Wander: head in a new random direction every 1 to 3 seconds
+            local angle = Random.Range(0, 2 * math.pi)
+            local rb = ECS.GetRigidbody(self.entity)
+            rb.velocity.x = math.cos(angle) * self.speed
+            rb.velocity.y = math.sin(angle) * self.speed
+            self.turnTimer = Random.Range(1, 3)
+        end
+    end
+end
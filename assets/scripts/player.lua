@@ -1,23 +1,27 @@
 function Start(self)
     -- self.entity is the entity ID this script is attached to
-    self.rb = ECS.GetRigidbody(self.entity)
+    self.jumpSound = Sound.GetID("jump")
+    self.acceleration = 360 -- world units per second, per second
     print("Player controller started for entity: " .. self.entity)
 end
 
 function Update(self)
+    -- Fetched every Update: with parallel script states this is a copy that is written back after the tick
+    local rb = ECS.GetRigidbody(self.entity)
+    local dv = self.acceleration * Time.DeltaTime()
     if Input.KeyHoldingDown(KEYBOARD.A) then
-        self.rb.velocity.x = self.rb.velocity.x - 0.1
+        rb.velocity.x = rb.velocity.x - dv
     end
     if Input.KeyHoldingDown(KEYBOARD.D) then
-        self.rb.velocity.x = self.rb.velocity.x + 0.1
+        rb.velocity.x = rb.velocity.x + dv
     end
     if Input.KeyHoldingDown(KEYBOARD.W) then
-        self.rb.velocity.y = self.rb.velocity.y + 0.1
+        rb.velocity.y = rb.velocity.y + dv
     end
     if Input.KeyHoldingDown(KEYBOARD.S) then
-        self.rb.velocity.y = self.rb.velocity.y - 0.1
+        rb.velocity.y = rb.velocity.y - dv
     end
     if Input.KeyJustPressed(KEYBOARD.SPACE) then
-        Sound.Play("jump")
+        Sound.PlayID(self.jumpSound)
     end
 end
\ No newline at end of file
@@ -0,0 +1,85 @@
+/*
+    Per-call overhead of the different ways a C++ function can be bound to Lua.
+    Built with the same sol2 configuration as the engine (see ScriptManager/SolConfig.h),
+    so running it in Debug and Release shows what SOL_ALL_SAFETIES_ON costs.
+
+        cmake -B build -DWILLENGINE_BUILD_BENCHMARKS=ON -DCMAKE_BUILD_TYPE=Release
+        cmake --build build --target binding_bench && ./build/binding_bench
+*/
+#include <ScriptManager/SolConfig.h>
+#include <glm/glm.hpp>
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+    constexpr int kCalls = 2000000;
+
+    bool keys[512];
+
+    int RawKeyDown(lua_State* L)
+    {
+        const bool* table = static_cast<const bool*>(lua_touserdata(L, lua_upvalueindex(1)));
+        lua_pushboolean(L, table[lua_tointeger(L, 1) & 511]);
+        return 1;
+    }
+
+    int RawVec2Add(lua_State* L)
+    {
+        const glm::vec2& a = sol::stack::unqualified_get<glm::vec2&>(L, 1);
+        const glm::vec2& b = sol::stack::unqualified_get<glm::vec2&>(L, 2);
+        return sol::stack::push(L, a + b);
+    }
+
+    // Runs `body` kCalls times inside a Lua loop and returns nanoseconds per iteration.
+    double Time(sol::state& lua, const char* body)
+    {
+        std::string code = std::string("local n = ...\nfor i = 1, n do\n") + body + "\nend";
+        sol::protected_function loop = lua.load(code).get<sol::protected_function>();
+
+        const auto start = std::chrono::steady_clock::now();
+        sol::protected_function_result result = loop(kCalls);
+        const auto end = std::chrono::steady_clock::now();
+        if (!result.valid()) {
+            sol::error err = result;
+            std::printf("error: %s\n", err.what());
+        }
+        return std::chrono::duration<double, std::nano>(end - start).count() / kCalls;
+    }
+}
+
+int main()
+{
+    sol::state lua;
+    lua.open_libraries(sol::lib::base);
+
+    lua["SolKeyDown"] = [](int key) { return keys[key & 511]; };
+    lua_pushlightuserdata(lua.lua_state(), keys);
+    lua_pushcclosure(lua.lua_state(), &RawKeyDown, 1);
+    lua_setglobal(lua.lua_state(), "RawKeyDown");
+
+    lua.new_usertype<glm::vec2>("vec2",
+        sol::call_constructor, sol::constructors<glm::vec2(float, float)>(),
+        "x", &glm::vec2::x,
+        "y", &glm::vec2::y,
+        sol::meta_function::addition, sol::overload([](const glm::vec2& a, const glm::vec2& b) -> glm::vec2 { return a + b; }));
+    lua["RawAdd"] = &RawVec2Add;
+    lua.script("a = vec2(1, 2) b = vec2(3, 4)");
+
+    const double empty = Time(lua, "");
+    const struct { const char* name; const char* body; } cases[] = {
+        { "sol2 lambda (int) -> bool", "SolKeyDown(65)" },
+        { "raw lua_CFunction", "RawKeyDown(65)" },
+        { "usertype field read", "local x = a.x" },
+        { "usertype field write", "a.x = i" },
+        { "vec2 + (sol::overload)", "local c = a + b" },
+        { "vec2 add (raw)", "local c = RawAdd(a, b)" },
+    };
+
+    std::printf("sol2 safeties: %s\n", WILLENGINE_FAST_BINDINGS ? "off" : "on");
+    std::printf("%-28s %10s\n", "binding", "ns/call");
+    for (const auto& c : cases) {
+        std::printf("%-28s %10.2f\n", c.name, Time(lua, c.body) - empty);
+    }
+    return 0;
+}
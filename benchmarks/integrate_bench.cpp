@@ -0,0 +1,128 @@
+/*
+    Physics integration throughput: the scalar kernel against the SIMD ones the CPU supports,
+    over packed bodies the way PhysicsManager::Update hands them over. Exits with 1 if a SIMD kernel
+    doesn't give the scalar kernel's results bit for bit.
+
+        cmake -B build -DWILLENGINE_BUILD_BENCHMARKS=ON -DCMAKE_BUILD_TYPE=Release
+        cmake --build build --target integrate_bench && ./build/integrate_bench
+*/
+#include <PhysicsManager/IntegrationKernels.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <random>
+
+namespace
+{
+    constexpr float kHalfWidth = 133.0f;
+    constexpr float kHalfHeight = 100.0f;
+    constexpr float kDt = 1.0f / 60.0f;
+
+    willengine::BodyArrays MakeBodies(size_t count)
+    {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+        std::uniform_real_distribution<float> velocity(-120.0f, 120.0f);
+        std::uniform_real_distribution<float> half(1.0f, 20.0f);
+
+        willengine::BodyArrays bodies;
+        for (size_t i = 0; i < count; ++i) {
+            bodies.Push({ position(random), position(random) }, { velocity(random), velocity(random) }, { half(random), half(random) });
+        }
+        return bodies;
+    }
+
+    double EntitiesPerSecond(willengine::IntegrateKernel kernel, size_t count, int ticks)
+    {
+        willengine::BodyArrays bodies = MakeBodies(count);
+        kernel(bodies, kDt, kHalfWidth, kHalfHeight);	// warm up
+        const auto start = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < ticks; ++tick) {
+            kernel(bodies, kDt, kHalfWidth, kHalfHeight);
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return double(count) * ticks / seconds;
+    }
+
+    bool SameBits(const std::vector<float>& a, const std::vector<float>& b)
+    {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+    }
+
+    bool SameBits(const willengine::BodyArrays& a, const willengine::BodyArrays& b)
+    {
+        return SameBits(a.px, b.px) && SameBits(a.py, b.py) && SameBits(a.vx, b.vx) && SameBits(a.vy, b.vy);
+    }
+
+    // Every kernel must give the scalar kernel's results, bit for bit.
+    bool MatchesScalar(willengine::IntegrateKernel kernel)
+    {
+        willengine::BodyArrays expected = MakeBodies(1003);
+        willengine::BodyArrays actual = expected;
+        for (int tick = 0; tick < 200; ++tick) {
+            willengine::IntegrateScalar(expected, kDt, kHalfWidth, kHalfHeight);
+            kernel(actual, kDt, kHalfWidth, kHalfHeight);
+        }
+        return SameBits(expected, actual);
+    }
+
+    // The inputs where SIMD min/max and std::min/max can disagree: +0 against -0, NaN, landing exactly on an edge.
+    // Repeated to 16 bodies so the packed loops see them, not only the scalar tail.
+    bool MatchesScalarOnEdgeCases(willengine::IntegrateKernel kernel)
+    {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        const willengine::vec2 cases[][3] = {
+            { { -0.0f, 0.0f }, { 0.0f, -0.0f }, { kHalfWidth, kHalfHeight } },	// collider as big as the world: both edges at 0
+            { { 0.0f, -0.0f }, { -0.0f, 0.0f }, { kHalfWidth, kHalfHeight } },
+            { { nan, 0.0f }, { 1.0f, 1.0f }, { 1.0f, 1.0f } },
+            { { 0.0f, 0.0f }, { nan, -nan }, { 1.0f, 1.0f } },
+            { { kHalfWidth - 1.0f, 1.0f - kHalfHeight }, { 0.0f, 0.0f }, { 1.0f, 1.0f } },	// resting on an edge
+            { { 1.0f, 1.0f }, { (kHalfWidth - 2.0f) / kDt, (2.0f - kHalfHeight) / kDt }, { 1.0f, 1.0f } },
+        };
+        willengine::BodyArrays expected;
+        for (size_t i = 0; i < 16; ++i) {
+            const auto& body = cases[i % std::size(cases)];
+            expected.Push(body[0], body[1], body[2]);
+        }
+        willengine::BodyArrays actual = expected;
+        willengine::IntegrateScalar(expected, kDt, kHalfWidth, kHalfHeight);
+        kernel(actual, kDt, kHalfWidth, kHalfHeight);
+        return SameBits(expected, actual);
+    }
+}
+
+int main()
+{
+    using willengine::SimdLevel;
+    const SimdLevel best = willengine::DetectSimdLevel();
+    std::printf("CPU supports: %s\n", willengine::SimdLevelName(best));
+
+    bool matches = true;
+    for (SimdLevel level : { SimdLevel::SSE2, SimdLevel::AVX }) {
+        if (level > best) continue;
+        const bool edgeCases = MatchesScalarOnEdgeCases(willengine::GetIntegrateKernel(level));
+        std::printf("%-6s on +0/-0/NaN/edge inputs: %s\n", willengine::SimdLevelName(level), edgeCases ? "matches scalar" : "MISMATCH");
+        matches = matches && edgeCases;
+    }
+
+    const size_t counts[] = { 1000, 10000, 100000, 1000000 };
+    for (size_t count : counts) {
+        const int ticks = int(std::max<size_t>(200000000 / count, 1) / 10);
+        const double scalar = EntitiesPerSecond(&willengine::IntegrateScalar, count, ticks);
+        std::printf("%8zu bodies  %-6s %8.1f M/s\n", count, "scalar", scalar / 1e6);
+
+        for (SimdLevel level : { SimdLevel::SSE2, SimdLevel::AVX }) {
+            if (level > best) continue;
+            willengine::IntegrateKernel kernel = willengine::GetIntegrateKernel(level);
+            const double rate = EntitiesPerSecond(kernel, count, ticks);
+            const bool same = MatchesScalar(kernel);
+            std::printf("%8zu bodies  %-6s %8.1f M/s  (%.2fx)%s\n", count, willengine::SimdLevelName(level), rate / 1e6, rate / scalar,
+                same ? "" : "  MISMATCH");
+            matches = matches && same;
+        }
+    }
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+/*
+    Plays an input recording as fast as the engine can tick, headless, and reports where tick time goes.
+    Record a session with the demo first (it runs deterministic while recording), then replay it:
+
+        ./build/helloworld --record session.weir
+        cmake -B build -DWILLENGINE_BUILD_BENCHMARKS=ON -DCMAKE_BUILD_TYPE=Release
+        cmake --build build --target replay_bench && ./build/replay_bench session.weir
+
+    Exits with 1 if the replay diverged from the recording (the state hashes stopped matching),
+    so a CI job can run it on a checked-in recording.
+*/
+#include <Engine.h>
+#include <InputManager/InputManager.h>
+#include <ScriptManager/ScriptManager.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    struct Stage
+    {
+        const char* name;
+        std::vector<double> samples;
+    };
+
+    double Percentile(std::vector<double> samples, double p)
+    {
+        if (samples.empty()) return 0.0;
+        const size_t index = std::min(samples.size() - 1, size_t(p * double(samples.size() - 1) + 0.5));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc < 2) {
+        std::printf("usage: %s <recording>\n", argv[0]);
+        return 2;
+    }
+
+    willengine::Engine::Config config;
+    if (!willengine::InputManager::ReadRecordingHeader(argv[1], config.tick_rate, config.random_seed)) {
+        std::printf("%s is not an input recording\n", argv[1]);
+        return 2;
+    }
+    config.headless = true;
+    config.deterministic = true;
+    config.input_replay_path = argv[1];
+
+    willengine::Engine engine{ config };
+    engine.script->StartAllEntityScripts();
+
+    Stage stages[] = { { "input" }, { "scripts" }, { "callback" }, { "physics" }, { "collision events" }, { "tick total" } };
+    const auto start = std::chrono::steady_clock::now();
+    while (engine.input->IsReplaying()) {
+        const auto tickStart = std::chrono::steady_clock::now();
+        const int ticks = engine.AdvanceSimulation([]() {}, true);
+        engine.frameArena.EndFrame();	// no engine loop here to do it
+        const double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tickStart).count();
+        if (ticks == 0) break;
+
+        const willengine::Engine::TickTimings& timings = engine.GetTickTimings();
+        stages[0].samples.push_back(timings.input);
+        stages[1].samples.push_back(timings.scripts);
+        stages[2].samples.push_back(timings.callback);
+        stages[3].samples.push_back(timings.physics);
+        stages[4].samples.push_back(timings.collisionEvents);
+        stages[5].samples.push_back(total);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const size_t ticks = stages[5].samples.size();
+    std::printf("%zu ticks in %.3f s (%.0f ticks/s, %.1fx real time)\n", ticks, seconds, double(ticks) / seconds,
+        double(ticks) / config.tick_rate / seconds);
+    std::printf("%-18s %10s %10s %10s %10s %10s\n", "stage (ms)", "mean", "p50", "p95", "p99", "max");
+    for (const Stage& stage : stages) {
+        double sum = 0.0;
+        for (double sample : stage.samples) sum += sample;
+        const double mean = stage.samples.empty() ? 0.0 : sum / double(stage.samples.size());
+        const double max = stage.samples.empty() ? 0.0 : *std::max_element(stage.samples.begin(), stage.samples.end());
+        std::printf("%-18s %10.4f %10.4f %10.4f %10.4f %10.4f\n", stage.name, mean,
+            Percentile(stage.samples, 0.50), Percentile(stage.samples, 0.95), Percentile(stage.samples, 0.99), max);
+    }
+    std::printf("final state hash: %016llx\n", (unsigned long long)engine.GetStateHash());
+
+    const int64_t divergence = engine.input->GetReplayDivergence();
+    engine.Shutdown();
+    if (divergence >= 0) {
+        std::printf("DIVERGED at tick %lld\n", (long long)divergence);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+    Gameplay-style Lua workload, for comparing scripting backends.
+    Build it once per backend and compare the numbers:
+
+        cmake -B build-lua -DWILLENGINE_BUILD_BENCHMARKS=ON -DCMAKE_BUILD_TYPE=Release
+        cmake -B build-jit -DWILLENGINE_BUILD_BENCHMARKS=ON -DCMAKE_BUILD_TYPE=Release -DWILLENGINE_LUA_BACKEND=luajit
+        cmake --build build-lua --target script_bench && ./build-lua/script_bench
+        cmake --build build-jit --target script_bench && ./build-jit/script_bench
+*/
+#include <ScriptManager/LuaCompat.h>
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+    constexpr int kEntities = 5000;
+    constexpr int kTicks = 600;
+
+    // Per-entity tables, the way entity scripts keep their state.
+    const char* kTables = R"(
+        local n, ticks = ...
+        local enemies = {}
+        for i = 1, n do
+            enemies[i] = { x = i % 100, y = i % 37, vx = 1, vy = -1 }
+        end
+        for t = 1, ticks do
+            for i = 1, n do
+                local e = enemies[i]
+                e.x = e.x + e.vx / 60
+                e.y = e.y + e.vy / 60
+                if e.x < -100 or e.x > 100 then e.vx = -e.vx end
+                if e.y < -100 or e.y > 100 then e.vy = -e.vy end
+            end
+        end
+    )";
+
+    // Flat arrays, the way ECS.Read<Name> hands out columns.
+    const char* kArrays = R"(
+        local n, ticks = ...
+        local px, py, vx, vy = {}, {}, {}, {}
+        for i = 1, n do
+            px[i], py[i], vx[i], vy[i] = i % 100, i % 37, 1, -1
+        end
+        for t = 1, ticks do
+            for i = 1, n do
+                local x, y = px[i] + vx[i] / 60, py[i] + vy[i] / 60
+                if x < -100 or x > 100 then vx[i] = -vx[i] end
+                if y < -100 or y > 100 then vy[i] = -vy[i] end
+                px[i], py[i] = x, y
+            end
+        end
+    )";
+
+    // Chasing a target with some math library calls.
+    const char* kSteering = R"(
+        local n, ticks = ...
+        local px, py = {}, {}
+        for i = 1, n do px[i], py[i] = math.cos(i) * 50, math.sin(i) * 50 end
+        local tx, ty = 0, 0
+        for t = 1, ticks do
+            tx, ty = math.cos(t / 60) * 10, math.sin(t / 60) * 10
+            for i = 1, n do
+                local dx, dy = tx - px[i], ty - py[i]
+                local len = math.sqrt(dx * dx + dy * dy) + 1e-6
+                px[i] = px[i] + dx / len * 0.5
+                py[i] = py[i] + dy / len * 0.5
+            end
+        end
+    )";
+
+    double TimeMs(sol::state& lua, const char* code)
+    {
+        sol::protected_function chunk = lua.load(code).get<sol::protected_function>();
+        const auto start = std::chrono::steady_clock::now();
+        sol::protected_function_result result = chunk(kEntities, kTicks);
+        const auto end = std::chrono::steady_clock::now();
+        if (!result.valid()) {
+            sol::error err = result;
+            std::printf("error: %s\n", err.what());
+        }
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+}
+
+int main()
+{
+    sol::state lua;
+    lua.open_libraries(sol::lib::base, sol::lib::math);
+    willengine::luacompat::OpenBackendLibraries(lua);
+
+    std::printf("backend: %s, %d entities x %d ticks\n", willengine::luacompat::kBackendName, kEntities, kTicks);
+    const struct { const char* name; const char* code; } cases[] = {
+        { "per-entity tables", kTables },
+        { "flat arrays", kArrays },
+        { "steering (math.*)", kSteering },
+    };
+    for (const auto& c : cases) {
+        const double ms = TimeMs(lua, c.code);
+        std::printf("%-20s %9.2f ms  (%6.1f ns/entity/tick)\n", c.name, ms, ms * 1e6 / (double(kEntities) * kTicks));
+    }
+    return 0;
+}
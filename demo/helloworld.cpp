@@ -1,5 +1,6 @@
 #include <iostream>
 #include <vector>
+#include <string>
 #include "Engine.h"
 #include "InputManager/InputManager.h"
 #include "GraphicsManager/GraphicsManager.h"
@@ -10,7 +11,21 @@
 
 int main(int argc, const char* argv[]) 
 {
-    willengine::Engine engine{ willengine::Engine::Config{} };
+    // --record <file>: save this session's input, to play it back later with --replay <file> or replay_bench.
+    willengine::Engine::Config config;
+    for (int i = 1; i + 1 < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--record") {
+            config.input_record_path = argv[++i];
+            config.deterministic = true;
+        }
+        else if (option == "--replay") {
+            config.input_replay_path = argv[++i];
+            config.deterministic = true;
+            willengine::InputManager::ReadRecordingHeader(config.input_replay_path, config.tick_rate, config.random_seed);
+        }
+    }
+    willengine::Engine engine{ config };
     
     engine.RunGameLoop([&](){
         // you can natively inject c++ code to the game engine from here.
@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace willengine
+{
+	/*
+		Bounded single-producer/single-consumer queue. Push() must only be called from one
+		thread and Pop() from one other thread; neither ever takes a lock or allocates.
+		Each side caches the other side's index so the shared atomics are only re-read when
+		the queue looks full (producer) or empty (consumer).
+	*/
+	template<typename T, size_t Capacity>
+	class SpscRing
+	{
+		static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+	public:
+		// Producer side. Returns false when the queue is full.
+		bool Push(const T& item)
+		{
+			const size_t currentHead = head.load(std::memory_order_relaxed);
+			if (currentHead - cachedTail == Capacity) {
+				cachedTail = tail.load(std::memory_order_acquire);
+				if (currentHead - cachedTail == Capacity) return false;
+			}
+			items[currentHead & (Capacity - 1)] = item;
+			head.store(currentHead + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer side. Returns false when the queue is empty.
+		bool Pop(T& out)
+		{
+			const size_t currentTail = tail.load(std::memory_order_relaxed);
+			if (currentTail == cachedHead) {
+				cachedHead = head.load(std::memory_order_acquire);
+				if (currentTail == cachedHead) return false;
+			}
+			out = items[currentTail & (Capacity - 1)];
+			tail.store(currentTail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Approximate, only meant for stats.
+		size_t Size() const
+		{
+			return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed);
+		}
+
+	private:
+		// Producer-owned line.
+		alignas(64) std::atomic<size_t> head{ 0 };
+		size_t cachedTail = 0;
+		// Consumer-owned line.
+		alignas(64) std::atomic<size_t> tail{ 0 };
+		size_t cachedHead = 0;
+
+		alignas(64) std::array<T, Capacity> items{};
+	};
+}
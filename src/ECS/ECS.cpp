@@ -12,8 +12,7 @@ namespace willengine
 
     entityID ECS::Create()
     {
-        m_nextID++;
-        return m_nextID;
+        return ++m_nextID;
     }
 
     void ECS::Destroy(entityID e)
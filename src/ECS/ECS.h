@@ -1,10 +1,14 @@
 #pragma once
 #include <Types.h>
+#include <Memory/FrameArena.h>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 #include <functional>
 #include <typeindex>
+#include <atomic>
+#include <algorithm>
+#include <array>
 
 namespace willengine
 {
@@ -47,13 +51,66 @@ namespace willengine
             return GetAppropriateSparseSet<T>()[entity];
         }
 
-        // Check if an entity has a given component
+        // Check if an entity has a given component. Doesn't insert, so it is safe to call from several threads.
         template<typename T>
         bool Has(entityID entity) 
         {
-            const ComponentIndex index = std::type_index(typeid(T));
-            if (m_components[index] == nullptr) return false;
-            return m_components[index]->Has(entity);
+            auto it = m_components.find(std::type_index(typeid(T)));
+            if (it == m_components.end() || it->second == nullptr) return false;
+            return it->second->Has(entity);
+        }
+
+        // Get a component if the entity has it, nullptr otherwise. One lookup instead of Has + Get.
+        template<typename T>
+        T* TryGet(entityID entity)
+        {
+            auto it = m_components.find(std::type_index(typeid(T)));
+            if (it == m_components.end() || it->second == nullptr) return nullptr;
+            auto& data = static_cast<SparseSet<T>&>(*it->second).data;
+            auto found = data.find(entity);
+            return found != data.end() ? &found->second : nullptr;
+        }
+
+        // Number of entities with a component of type T.
+        template<typename T>
+        size_t Count() const
+        {
+            auto it = m_components.find(std::type_index(typeid(T)));
+            if (it == m_components.end() || it->second == nullptr) return 0;
+            return static_cast<const SparseSet<T>&>(*it->second).data.size();
+        }
+
+        // Scratch memory of ForEach and ForEachComponent, when they run on the arena's thread. Null: the heap.
+        void SetFrameArena(FrameArena* arena) { m_frameArena = arena; }
+
+        // Ordered iteration: ForEach and ForEachComponent visit entities by ascending ID instead of in
+        // hash map order, which is unspecified and differs between standard libraries. Costs a sort per call.
+        void SetOrderedIteration(bool ordered) { m_ordered = ordered; }
+        bool IsOrderedIteration() const { return m_ordered; }
+
+        // Visit every component of type T along with its entity, without a lookup per entity.
+        template<typename T, typename Func>
+        void ForEachComponent(Func&& func)
+        {
+            auto it = m_components.find(std::type_index(typeid(T)));
+            if (it == m_components.end() || it->second == nullptr) return;
+            auto& data = static_cast<SparseSet<T>&>(*it->second).data;
+            if (!m_ordered) {
+                for (auto& [entity, component] : data) {
+                    func(entity, component);
+                }
+                return;
+            }
+
+            FrameVector<std::pair<entityID, T*>> sorted{ FrameAllocator<std::pair<entityID, T*>>(Scratch()) };
+            sorted.reserve(data.size());
+            for (auto& [entity, component] : data) {
+                sorted.emplace_back(entity, &component);
+            }
+            std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+            for (auto& [entity, component] : sorted) {
+                func(entity, *component);
+            }
         }
 
         // Drop a component from an entity
@@ -69,8 +126,8 @@ namespace willengine
         template<typename EntitiesThatHaveThisComponent, typename... AndAlsoTheseComponents>
         void ForEach(const ForEachCallback& callback)
         {
-            // Get a vector of ComponentIndex we can use with `m_components[index]->Has(entity)`.
-            std::vector<ComponentIndex> also{ std::type_index(typeid(AndAlsoTheseComponents))... };
+            // Get the ComponentIndex of each other component, to use with `m_components[index]->Has(entity)`.
+            const std::array<ComponentIndex, sizeof...(AndAlsoTheseComponents)> also{ std::type_index(typeid(AndAlsoTheseComponents))... };
 
             // Iterate over entities in the first container.
             const ComponentIndex firstIndex = std::type_index(typeid(EntitiesThatHaveThisComponent));
@@ -82,6 +139,10 @@ namespace willengine
             auto& sparseSet = GetAppropriateSparseSet<EntitiesThatHaveThisComponent>();
 
             // Iterate over all entities that have the first component
+            FrameVector<entityID> matching{ FrameAllocator<entityID>(Scratch()) };
+            if (m_ordered) {
+                matching.reserve(sparseSet.size());
+            }
             for (const auto& [entity, component] : sparseSet) {
                 // Check if the entity has all the other required components
                 bool hasAllComponents = true;
@@ -93,15 +154,33 @@ namespace willengine
                 }
 
                 // If the entity has all required components, call the callback
-                if (hasAllComponents) {
+                if (!hasAllComponents) continue;
+                if (m_ordered) {
+                    matching.push_back(entity);
+                }
+                else {
+                    callback(entity);
+                }
+            }
+
+            if (m_ordered) {
+                std::sort(matching.begin(), matching.end());
+                for (entityID entity : matching) {
                     callback(entity);
                 }
             }
         }
 
     private:
-        entityID m_nextID;
+        std::atomic<entityID> m_nextID;	// atomic: script threads create entities too
         std::unordered_map<ComponentIndex, std::unique_ptr<SparseSetHolder>> m_components;
+        bool m_ordered = false;
+        FrameArena* m_frameArena = nullptr;
+
+        FrameArena* Scratch() const
+        {
+            return m_frameArena && m_frameArena->IsOwnerThread() ? m_frameArena : nullptr;
+        }
 
         // Get the appropriate sparse set for a given component type
         template<typename T>
@@ -6,7 +6,13 @@
 #include "SoundManager/SoundManager.h"
 #include "PhysicsManager/PhysicsManager.h"
 #include "SceneManager/SceneManager.h"
+#include "Simulation/StateHash.h"
+#include "Tracing/Trace.h"
+#include <spdlog/spdlog.h>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
 
 namespace willengine
 {
@@ -20,6 +26,7 @@ namespace willengine
 		  script(new ScriptManager(this)),
 		  event(new EventManager),
 	      sound(new SoundManager(this)),
+		  metrics(new Metrics(this)),
 		  running(false)
 	{
 		Startup(config);
@@ -34,15 +41,39 @@ namespace willengine
 		delete script;
 		delete sound;
 		delete scene;
+		delete metrics;
 	}
 
 	void Engine::Startup(Config config)
 	{
+		WILLENGINE_TRACE_THREAD("Main");
+		tickDelta = 1.0 / std::max(this->config.tick_rate, 1.0);
+		this->config.max_ticks_per_frame = std::max(this->config.max_ticks_per_frame, 1);
+		if (this->config.deterministic) {
+			// Parallel script states create entities concurrently, so IDs would depend on thread timing.
+			if (this->config.script_threads > 1) {
+				spdlog::warn("Deterministic mode runs entity scripts on one Lua state (script_threads {} ignored)", this->config.script_threads);
+				this->config.script_threads = 1;
+			}
+			ecs.SetOrderedIteration(true);
+		}
+		ecs.SetFrameArena(&frameArena);
 		graphics->Startup(this->config);
+		input->Startup();
+		if (!this->config.input_replay_path.empty()) {
+			input->StartReplay(this->config.input_replay_path);
+		}
+		else if (!this->config.input_record_path.empty()) {
+			input->StartRecording(this->config.input_record_path);
+		}
 		physics->Startup(this->config);
-		script->Startup();
-		sound->Startup();
+		resource->Startup(this->config);
+		script->Startup(this->config);
+		sound->Startup(this->config.headless);
 		scene->Startup();
+		if (this->config.hot_reload) {
+			resource->StartHotReload();
+		}
 		running = true;
 	}
 
@@ -53,28 +84,23 @@ namespace willengine
 
 	void Engine::RunGameLoop(const UpdateCallback& callback)
 	{
-
-					
-		double now = glfwGetTime();
-		double timePerExecution = 1.0 / 60.0;
-		double lastTick = now - timePerExecution;
-
 		script->StartAllEntityScripts();
+		ResetSimulationClock();
 
 		while (running && !graphics->ShouldQuit())
 		{
-			now = glfwGetTime();
-			while (now >= lastTick + timePerExecution)
-			{
-				input->Update();
-				script->UpdateAllEntityScripts();
-				callback();
-				lastTick += timePerExecution;
-				physics->Update();
-			}
+			WILLENGINE_TRACE_ZONE("Frame");
+			resource->ProcessHotReload();
+			input->PollEvents();
+			AdvanceSimulation(callback, true);
 
+			const double drawStart = glfwGetTime();
 			graphics->Draw();
-
+			const double drawMs = (glfwGetTime() - drawStart) * 1000.0;
+			script->StepGarbageCollector();
+			script->EndProfileFrame();
+			metrics->EndFrame(drawMs);
+			frameArena.EndFrame();
 		}
 	}
 
@@ -82,16 +108,129 @@ namespace willengine
 	{
 		while (running && !graphics->ShouldQuit())
 		{
+			WILLENGINE_TRACE_ZONE("Frame");
+			resource->ProcessHotReload();
+			input->PollEvents();
 			input->Update();
 
 			editorCallback();  // Prepares ImGui (NewFrame, widgets, Render)
 
+			const double drawStart = glfwGetTime();
 			graphics->DrawWithEditor(renderCallback);  // Draws sprites + ImGui in one pass
+			const double drawMs = (glfwGetTime() - drawStart) * 1000.0;
+			script->StepGarbageCollector();
+			script->EndProfileFrame();
+			metrics->EndFrame(drawMs);
+			frameArena.EndFrame();
+		}
+	}
+
+	int Engine::AdvanceSimulation(const UpdateCallback& callback, bool pollInput)
+	{
+		// A replay that has run out stops the game instead of ticking on without its input.
+		// Checked before every tick: here for the first, in the catch-up loop for the others.
+		if (input->IsReplayFinished()) {
+			Stop();
+			return 0;
+		}
+
+		// Headless or replaying a recording: nobody is watching in real time, so tick as fast as frames come.
+		// Every tick still simulates tickDelta, and replayed input is per tick, so the result is the same.
+		if (config.headless || input->IsReplaying()) {
+			Tick(callback, pollInput);
+			return 1;
+		}
+
+		const double now = glfwGetTime();
+		if (lastAdvance < 0.0) {
+			lastAdvance = now;
+			return 0;
+		}
+		tickAccumulator += now - lastAdvance;
+		lastAdvance = now;
+
+		int ticks = 0;
+		while (tickAccumulator >= tickDelta && ticks < config.max_ticks_per_frame)
+		{
+			if (ticks > 0 && input->IsReplayFinished()) {
+				Stop();
+				tickAccumulator = 0.0;
+				return ticks;
+			}
+			Tick(callback, pollInput);
+			tickAccumulator -= tickDelta;
+			ticks++;
+		}
+
+		// Spiral-of-death guard: if ticks cost more than they simulate, catching up only adds more ticks.
+		// Drop the backlog instead, game time runs slower than real time until the load goes down.
+		if (tickAccumulator >= tickDelta) {
+			const double kept = std::fmod(tickAccumulator, tickDelta);
+			droppedTime += tickAccumulator - kept;
+			tickAccumulator = kept;
+		}
+		return ticks;
+	}
+
+	void Engine::ResetSimulationClock()
+	{
+		lastAdvance = -1.0;
+		tickAccumulator = 0.0;
+	}
+
+	void Engine::Tick(const UpdateCallback& callback, bool pollInput)
+	{
+		using clock = std::chrono::steady_clock;
+		auto milliseconds = [](clock::time_point from, clock::time_point to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+
+		WILLENGINE_TRACE_ZONE("Tick");
+		const clock::time_point start = clock::now();
+		if (pollInput) {
+			WILLENGINE_TRACE_ZONE("Input::Update");
+			input->Update();
+		}
+		const clock::time_point inputDone = clock::now();
+		script->UpdateAllEntityScripts();
+		const clock::time_point scriptsDone = clock::now();
+		{
+			WILLENGINE_TRACE_ZONE("Game callback");
+			callback();
+		}
+		const clock::time_point callbackDone = clock::now();
+		physics->Update(float(tickDelta));
+		const clock::time_point physicsDone = clock::now();
+		script->DispatchCollisions();
+		const clock::time_point collisionsDone = clock::now();
+
+		tickTimings.input = milliseconds(start, inputDone);
+		tickTimings.scripts = milliseconds(inputDone, scriptsDone);
+		tickTimings.callback = milliseconds(scriptsDone, callbackDone);
+		tickTimings.physics = milliseconds(callbackDone, physicsDone);
+		tickTimings.collisionEvents = milliseconds(physicsDone, collisionsDone);
+		metrics->AddTick(tickTimings);
+
+		tickCount++;
+		if (config.deterministic) {
+			WILLENGINE_TRACE_ZONE("HashSimulationState");
+			stateHash = HashSimulationState(ecs);
+		}
+		if (pollInput) {
+			input->EndTick();
 		}
 	}
 
 	void Engine::Shutdown()
 	{
+		resource->StopHotReload();
+		input->StopRecording();
+		if (!config.trace_path.empty()) {
+			if (trace::WriteChromeTrace(config.trace_path)) {
+				spdlog::info("Wrote trace to '{}'", config.trace_path);
+			}
+			else {
+				spdlog::warn("No trace written to '{}' (tracing needs -DWILLENGINE_ENABLE_TRACING=ON)", config.trace_path);
+			}
+		}
 		sound->Shutdown();
 		script->Shutdown();
 		graphics->Shutdown();
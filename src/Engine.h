@@ -5,7 +5,9 @@
 #include "GLFW/glfw3.h"
 #include <string>
 #include "ECS/ECS.h"
+#include "Memory/FrameArena.h"
 #include "EventManager/EventManager.h"
+#include "Metrics/Metrics.h"
 
 
 namespace willengine
@@ -21,11 +23,44 @@ namespace willengine
 			int window_height = 1080;
 			std::string window_name = "WillEngine";
 			bool window_fullscreen = false;
+			bool headless = false; // No window, no GPU, no audio device; nothing is drawn. For replays and benchmarks
 
 			/* actual world bounds (centered at 0) */
 			float aspectRatio = float(window_width) / float(window_height);
 			float worldHalfHeight = 100.0f; // From projection: 1/0.01 = 100, it's hardcoded in graphics(?)
 			float worldHalfWidth = worldHalfHeight * aspectRatio;  // ~133 for 800x600
+
+			// Physics
+			float collision_cell_size = 40.0f; // Broad phase grid cell, in world units. About the size of a typical collider works best
+			bool physics_simd = true; // Integrate with the widest SIMD the CPU has (SSE2/AVX); false for the scalar kernel. Ignored when deterministic
+			int physics_max_substeps = 4; // Collision checks per step for bodies moving more than their own size per step; 1 turns it off
+
+			// Simulation clock
+			double tick_rate = 60.0; // Fixed simulation steps per second: scripts and physics always see dt = 1 / tick_rate
+			int max_ticks_per_frame = 5; // Catch-up limit. Time beyond it is dropped: the game slows down instead of spiraling
+
+			// Determinism
+			bool deterministic = false; // Entities visited in ID order, one script state, scalar physics, a state hash every tick
+			uint64_t random_seed = 0; // Seed of the Lua Random namespace (and of math.random when deterministic)
+
+			// Input recording
+			std::string input_record_path; // Non-empty: write every tick's input to this file
+			std::string input_replay_path; // Non-empty: play this recording instead of live input, stop the game loop when it ends
+
+			// Tracing (builds with WILLENGINE_ENABLE_TRACING only)
+			std::string trace_path; // Non-empty: Shutdown writes the timing zones there as Chrome trace JSON
+
+			// Assets
+			bool hot_reload = false; // Watch the assets folder and re-import changed scripts, sprites and sounds
+			bool asset_cache = true; // Keep decoded assets in assets/.cache so unchanged files aren't decoded again
+
+			// Lua garbage collector
+			bool lua_gc_generational = false; // Generational instead of incremental collection (Lua 5.4 only)
+			double lua_gc_budget_ms = 0.0; // > 0: no automatic collection mid-frame, the GC runs in steps after Draw for up to this long
+			int lua_gc_step_kb = 32; // Work per step when stepping manually
+
+			// Scripting
+			int script_threads = 1; // > 1: entity scripts are spread over this many Lua states, updated in parallel
 		};
 
 
@@ -39,18 +74,50 @@ namespace willengine
 		void RunEditorLoop(const UpdateCallback& editorCallback, const RenderCallback& renderCallback);
 		Config& BringEngineConfiguration();
 
+		// Fixed-timestep simulation. Runs the ticks the time since the last call is owed (scripts, `callback`,
+		// physics), at most Config::max_ticks_per_frame; the rest of the backlog is dropped. Returns the ticks run.
+		// Headless or replaying, it runs one tick per call instead, as fast as the caller loops. Once a replay
+		// has played its last tick, it ticks no more and stops the engine.
+		// pollInput: each tick takes an input snapshot. Window events are pumped by the caller (InputManager::PollEvents).
+		int AdvanceSimulation(const UpdateCallback& callback, bool pollInput);
+		// Forget the time passed since the last AdvanceSimulation, e.g. after a pause.
+		void ResetSimulationClock();
+		double GetTickDelta() const { return tickDelta; }
+		uint64_t GetTickCount() const { return tickCount; }
+		// Game time lost to the catch-up limit since startup, in seconds.
+		double GetDroppedTime() const { return droppedTime; }
+		// Config::deterministic: HashSimulationState after the last tick. Runs with the same inputs must agree
+		// on it at every tick; the first tick they don't is where they diverged.
+		uint64_t GetStateHash() const { return stateHash; }
+
+		// Wall time of each stage of the last tick, in milliseconds.
+		using TickTimings = ::willengine::TickTimings;
+		const TickTimings& GetTickTimings() const { return tickTimings; }
+
 		GraphicsManager* graphics;
 		PhysicsManager* physics;
 		InputManager* input;
 		ResourceManager* resource;
 		ScriptManager* script;
+		FrameArena frameArena;	// scratch memory for the current frame, reset by the engine loops
 		ECS ecs;
 		EventManager* event;
 		SoundManager* sound;
 		SceneManager* scene;
+		Metrics* metrics;	// frame time, tick timings, pool sizes, draw calls, asset memory
 		bool running;
 
 	private:
+		void Tick(const UpdateCallback& callback, bool pollInput);
+
 		Config config;
+
+		double tickDelta = 1.0 / 60.0;
+		double tickAccumulator = 0.0;
+		double lastAdvance = -1.0;	// < 0: clock not started
+		uint64_t tickCount = 0;
+		double droppedTime = 0.0;
+		uint64_t stateHash = 0;
+		TickTimings tickTimings;
 	};
 }
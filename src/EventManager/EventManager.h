@@ -4,6 +4,7 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <iterator>
 namespace willengine
 {
     class Event 
@@ -95,15 +96,23 @@ namespace willengine
         template <typename TEvent, typename ...TArgs>
         void EmitEvent(TArgs&& ...args)
         {
-            auto handlers = subscribers[typeid(TEvent)].get();
-            if (handlers)
+            // find, not [], so emitting an event nobody listens to doesn't insert an empty entry.
+            auto found = subscribers.find(typeid(TEvent));
+            if (found == subscribers.end() || !found->second) return;
+
+            // Built once: building it per handler moved from forwarded arguments after the first. Each handler
+            // still gets its own copy, so one that changes its event doesn't change what the next one sees.
+            // The last handler gets the prototype itself, so a single subscriber costs no copy.
+            TEvent prototype(std::forward<TArgs>(args)...);
+            HandlerList& handlers = *found->second;
+            for (auto it = handlers.begin(); it != handlers.end(); it++)
             {
-                for (auto it = handlers->begin(); it != handlers->end(); it++)
-                {
-                    auto handler = it->get();
-                    TEvent event(std::forward<TArgs>(args)...);
-                    handler->Execute(event);
+                if (std::next(it) == handlers.end()) {
+                    it->get()->Execute(prototype);
+                    break;
                 }
+                TEvent event(prototype);
+                it->get()->Execute(event);
             }
         }
 
@@ -0,0 +1,182 @@
+#include "FileWatcher.h"
+#include <algorithm>
+#include <chrono>
+#include <spdlog/spdlog.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace willengine
+{
+#ifdef __linux__
+	FileWatcher::FileWatcher()
+		:running(false), inotifyFd(-1), wakeFd(-1)
+	{
+	}
+#else
+	FileWatcher::FileWatcher()
+		:running(false)
+	{
+	}
+#endif
+
+	FileWatcher::~FileWatcher()
+	{
+		Stop();
+	}
+
+	bool FileWatcher::Start(const std::filesystem::path& root)
+	{
+		if (running) return true;
+
+		if (!std::filesystem::exists(root)) {
+			spdlog::warn("FileWatcher: directory not found: {}", root.string());
+			return false;
+		}
+		this->root = root;
+
+#ifdef __linux__
+		inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (inotifyFd < 0 || wakeFd < 0) {
+			spdlog::error("FileWatcher: failed to create inotify instance");
+			if (inotifyFd >= 0) close(inotifyFd);
+			if (wakeFd >= 0) close(wakeFd);
+			inotifyFd = wakeFd = -1;
+			return false;
+		}
+		AddWatchRecursive(root);
+#else
+		// Record the current state so only later edits are reported.
+		ScanForChanges(false);
+#endif
+
+		running = true;
+		worker = std::thread(&FileWatcher::WatchLoop, this);
+		spdlog::info("Watching '{}' for asset changes", root.string());
+		return true;
+	}
+
+	void FileWatcher::Stop()
+	{
+		if (!running) return;
+		running = false;
+
+#ifdef __linux__
+		uint64_t one = 1;
+		(void)write(wakeFd, &one, sizeof(one));
+#endif
+		if (worker.joinable()) worker.join();
+
+#ifdef __linux__
+		close(inotifyFd);
+		close(wakeFd);
+		inotifyFd = wakeFd = -1;
+		watchedDirs.clear();
+#endif
+	}
+
+	void FileWatcher::PollChanges(std::vector<std::filesystem::path>& changed)
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		changed.insert(changed.end(), pending.begin(), pending.end());
+		pending.clear();
+	}
+
+	void FileWatcher::QueueChange(const std::filesystem::path& path)
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		// Editors tend to write a file several times in a row; only report it once per poll.
+		if (std::find(pending.begin(), pending.end(), path) == pending.end()) {
+			pending.push_back(path);
+		}
+	}
+
+#ifdef __linux__
+	void FileWatcher::AddWatchRecursive(const std::filesystem::path& dir)
+	{
+		// IN_CLOSE_WRITE catches in-place saves, IN_MOVED_TO catches editors that save through a temp file.
+		int wd = inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (wd < 0) {
+			spdlog::warn("FileWatcher: cannot watch {}", dir.string());
+			return;
+		}
+		watchedDirs[wd] = dir;
+
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+			if (entry.is_directory()) {
+				AddWatchRecursive(entry.path());
+			}
+		}
+	}
+
+	void FileWatcher::WatchLoop()
+	{
+		alignas(inotify_event) char buffer[4096];
+		pollfd fds[2] = { { inotifyFd, POLLIN, 0 }, { wakeFd, POLLIN, 0 } };
+
+		while (running)
+		{
+			if (poll(fds, 2, -1) <= 0) continue;
+			if (fds[1].revents & POLLIN) break;
+
+			ssize_t length;
+			while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+			{
+				for (char* ptr = buffer; ptr < buffer + length; )
+				{
+					const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+					ptr += sizeof(inotify_event) + event->len;
+
+					auto dirIt = watchedDirs.find(event->wd);
+					if (dirIt == watchedDirs.end() || event->len == 0) continue;
+
+					std::filesystem::path path = dirIt->second / event->name;
+					if (event->mask & IN_ISDIR) {
+						// New sub folders have to be watched too.
+						if (event->mask & (IN_CREATE | IN_MOVED_TO)) AddWatchRecursive(path);
+					}
+					else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+						QueueChange(path);
+					}
+				}
+			}
+		}
+	}
+#else
+	void FileWatcher::ScanForChanges(bool queueChanges)
+	{
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(root, ec))
+		{
+			if (!entry.is_regular_file()) continue;
+
+			std::filesystem::file_time_type writeTime = entry.last_write_time(ec);
+			if (ec) continue;
+
+			auto [it, inserted] = lastWriteTimes.try_emplace(entry.path().string(), writeTime);
+			if (!inserted && it->second != writeTime) {
+				it->second = writeTime;
+				if (queueChanges) QueueChange(entry.path());
+			}
+			else if (inserted && queueChanges) {
+				QueueChange(entry.path());
+			}
+		}
+	}
+
+	void FileWatcher::WatchLoop()
+	{
+		while (running)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(250));
+			ScanForChanges(true);
+		}
+	}
+#endif
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace willengine
+{
+	/*
+		Watches a directory tree on a background thread and collects the files that changed.
+		Linux uses inotify, other platforms fall back to scanning modification times.
+		Nothing is reloaded from the watcher thread; the engine drains the changes with
+		PollChanges() at a frame boundary and re-imports them on the main thread.
+	*/
+	class FileWatcher
+	{
+	public:
+		FileWatcher();
+		~FileWatcher();
+
+		bool Start(const std::filesystem::path& root);
+		void Stop();
+		bool IsRunning() const { return running; }
+
+		// Moves every path that changed since the last call into `changed` (no duplicates).
+		void PollChanges(std::vector<std::filesystem::path>& changed);
+
+	private:
+		void WatchLoop();
+		void QueueChange(const std::filesystem::path& path);
+
+		std::filesystem::path root;
+		std::thread worker;
+		std::atomic<bool> running;
+
+		std::mutex pendingMutex;
+		std::vector<std::filesystem::path> pending;
+
+#ifdef __linux__
+		void AddWatchRecursive(const std::filesystem::path& dir);
+
+		int inotifyFd;
+		int wakeFd;		// eventfd used to wake the watcher thread on Stop()
+		std::unordered_map<int, std::filesystem::path> watchedDirs;
+#else
+		void ScanForChanges(bool queueChanges);
+
+		std::unordered_map<std::string, std::filesystem::file_time_type> lastWriteTimes;
+#endif
+	};
+}
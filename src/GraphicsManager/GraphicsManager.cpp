@@ -9,6 +9,7 @@
 #include <spdlog/spdlog.h>
 #include <webgpu/webgpu.h>
 #include <glfw3webgpu.h>
+#include "../Tracing/Trace.h"
 namespace
 {
 	struct InstanceData {
@@ -20,6 +21,12 @@ namespace
 	struct Uniforms {
 		willengine::mat4 projection;
 	};
+
+	// A sprite to draw and where. Points into the ECS, which doesn't change while drawing.
+	struct SpriteDraw {
+		const willengine::Sprite* sprite;
+		const willengine::Transform* transform;
+	};
 }
 namespace willengine
 {
@@ -46,6 +53,16 @@ namespace willengine
 
 	void GraphicsManager::Startup(Engine::Config config)
 	{
+		if (config.headless) {
+			// GLFW still runs the clock and the (empty) event loop, on its null platform so no display is needed.
+			headless = true;
+			window = nullptr;
+			glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+			glfwInit();
+			spdlog::info("Running headless: no window, nothing is drawn");
+			return;
+		}
+
 		glfwInit();
 		// We don't want GLFW to set up a graphics API.
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -320,6 +337,12 @@ namespace willengine
 
 	void GraphicsManager::Shutdown()
 	{
+		if (headless) {
+			texturesMap.clear();
+			glfwTerminate();
+			return;
+		}
+
 		// Release textures
 		for (auto& pair : texturesMap) {
 			if (pair.second.texture) wgpuTextureRelease(pair.second.texture);
@@ -342,22 +365,25 @@ namespace willengine
 	}
 	void GraphicsManager::Draw()
 	{
+		renderStats = RenderStats{};
+		if (headless) return;
+		WILLENGINE_TRACE_ZONE("Graphics::Draw");
 
-		// Collect all sprites from the ECS
-		std::vector<Sprite> sprites_to_draw;
-		std::vector<Transform> transforms;
+		// Collect all sprites from the ECS. The list lives in the frame arena, so drawing doesn't touch the heap.
+		FrameVector<SpriteDraw> sprites{ FrameAllocator<SpriteDraw>(&engine->frameArena) };
+		sprites.reserve(engine->ecs.Count<Sprite>());
 
-		engine->ecs.ForEach<Sprite, Transform>([&](entityID entity) 
-			{
-			Sprite& sprite = engine->ecs.Get<Sprite>(entity);
-			Transform& transform = engine->ecs.Get<Transform>(entity);
-			sprites_to_draw.emplace_back(sprite);
-			transforms.emplace_back(transform);
-			});
+		{
+			WILLENGINE_TRACE_ZONE("Graphics::Gather");
+			engine->ecs.ForEach<Sprite, Transform>([&](entityID entity) 
+				{
+				sprites.push_back(SpriteDraw{ &engine->ecs.Get<Sprite>(entity), &engine->ecs.Get<Transform>(entity) });
+				});
+		}
 
 
 		// If no sprites, just clear the screen
-		if (sprites_to_draw.empty()) {
+		if (sprites.empty()) {
 			WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
 			WGPUSurfaceTexture surface_texture{};
 			wgpuSurfaceGetCurrentTexture(surface, &surface_texture);
@@ -386,9 +412,12 @@ namespace willengine
 		}
 
 		// Sort sprites back-to-front (higher z first)
-		auto sprites = sprites_to_draw;
-		std::sort(sprites.begin(), sprites.end(), 
-			[](const Sprite& lhs, const Sprite& rhs) { return lhs.alpha > rhs.alpha; });
+		renderStats.sprites = uint32_t(sprites.size());
+		{
+			WILLENGINE_TRACE_ZONE("Graphics::Sort");
+			std::sort(sprites.begin(), sprites.end(), 
+				[](const SpriteDraw& lhs, const SpriteDraw& rhs) { return lhs.sprite->alpha > rhs.sprite->alpha; });
+		}
 
 		// Allocate/reallocate instance buffer if needed
 		if (instance_buffer_capacity < sprites.size()) {
@@ -426,87 +455,96 @@ namespace willengine
 		wgpuRenderPassEncoderSetVertexBuffer(render_pass, 0, vertex_buffer, 0, 4 * 4 * sizeof(float));
 		wgpuRenderPassEncoderSetVertexBuffer(render_pass, 1, instance_buffer, 0, sizeof(InstanceData) * sprites.size());
 
-		// Draw each sprite
-		std::string current_image = "";
-		for (size_t i = 0; i < sprites.size(); ++i) {
-			const Sprite& sprite = sprites[i];
-			const Transform& transform = transforms[i];
+		// Draw each sprite: instance upload and draw calls
+		{
+			WILLENGINE_TRACE_ZONE("Graphics::Record");
+			const std::string* current_image = nullptr;
+			for (size_t i = 0; i < sprites.size(); ++i) {
+				const Sprite& sprite = *sprites[i].sprite;
+				const Transform& transform = *sprites[i].transform;
 			
-			// Check if texture exists
-			auto it = texturesMap.find(sprite.image);
-			if (it == texturesMap.end()) {
-				spdlog::warn("Texture '{}' not found, skipping sprite", sprite.image);
-				continue;
-			}
+				// Check if texture exists
+				auto it = texturesMap.find(sprite.image);
+				if (it == texturesMap.end()) {
+					spdlog::warn("Texture '{}' not found, skipping sprite", sprite.image);
+					continue;
+				}
 			
-			const ImageData& image_data = it->second;
+				const ImageData& image_data = it->second;
 			
-			// Compute instance data
-			InstanceData instance_data;
-			instance_data.translation.x = transform.x;
-			instance_data.translation.y = transform.y;
-			instance_data.translation.z = sprite.alpha;
+				// Compute instance data
+				InstanceData instance_data;
+				instance_data.translation.x = transform.x;
+				instance_data.translation.y = transform.y;
+				instance_data.translation.z = sprite.alpha;
 			
-			// Scale to maintain aspect ratio
-			vec2 aspect_scale;
-			if (image_data.width < image_data.height) {
-				aspect_scale = vec2(float(image_data.width) / image_data.height, 1.0f);
-			} else {
-				aspect_scale = vec2(1.0f, float(image_data.height) / image_data.width);
-			}
-			instance_data.scale = aspect_scale * sprite.scale;
+				// Scale to maintain aspect ratio
+				vec2 aspect_scale;
+				if (image_data.width < image_data.height) {
+					aspect_scale = vec2(float(image_data.width) / image_data.height, 1.0f);
+				} else {
+					aspect_scale = vec2(1.0f, float(image_data.height) / image_data.width);
+				}
+				instance_data.scale = aspect_scale * sprite.scale;
 			
-			// Upload instance data to GPU
-			wgpuQueueWriteBuffer(queue, instance_buffer, i * sizeof(InstanceData), &instance_data, sizeof(InstanceData));
+				// Upload instance data to GPU
+				wgpuQueueWriteBuffer(queue, instance_buffer, i * sizeof(InstanceData), &instance_data, sizeof(InstanceData));
+				renderStats.instanceBytesUploaded += sizeof(InstanceData);
 			
-			// Set bind group if image changed
-			if (sprite.image != current_image) {
-				current_image = sprite.image;
+				// Set bind group if image changed
+				if (!current_image || sprite.image != *current_image) {
+					current_image = &sprite.image;
 				
-				// Create bind group if it doesn't exist
-				if (!image_data.bindGroup) {
-					auto layout = wgpuRenderPipelineGetBindGroupLayout(pipeline, 0);
-					WGPUBindGroup bind_group = wgpuDeviceCreateBindGroup(device, to_ptr(WGPUBindGroupDescriptor{
-						.layout = layout,
-						.entryCount = 3,
-						.entries = to_ptr<WGPUBindGroupEntry>({
-							{
-								.binding = 0,
-								.buffer = uniform_buffer,
-								.size = sizeof(Uniforms)
-							},
-							{
-								.binding = 1,
-								.sampler = sampler,
-							},
-							{
-								.binding = 2,
-								.textureView = wgpuTextureCreateView(image_data.texture, nullptr)
-							}
-							})
-						}));
-					wgpuBindGroupLayoutRelease(layout);
+					// Create bind group if it doesn't exist
+					if (!image_data.bindGroup) {
+						auto layout = wgpuRenderPipelineGetBindGroupLayout(pipeline, 0);
+						WGPUBindGroup bind_group = wgpuDeviceCreateBindGroup(device, to_ptr(WGPUBindGroupDescriptor{
+							.layout = layout,
+							.entryCount = 3,
+							.entries = to_ptr<WGPUBindGroupEntry>({
+								{
+									.binding = 0,
+									.buffer = uniform_buffer,
+									.size = sizeof(Uniforms)
+								},
+								{
+									.binding = 1,
+									.sampler = sampler,
+								},
+								{
+									.binding = 2,
+									.textureView = wgpuTextureCreateView(image_data.texture, nullptr)
+								}
+								})
+							}));
+						wgpuBindGroupLayoutRelease(layout);
 					
-					// Store it (need to cast away const since we're caching)
-					const_cast<ImageData&>(image_data).bindGroup = bind_group;
-				}
+						// Store it (need to cast away const since we're caching)
+						const_cast<ImageData&>(image_data).bindGroup = bind_group;
+					}
 				
-				wgpuRenderPassEncoderSetBindGroup(render_pass, 0, image_data.bindGroup, 0, nullptr);
-			}
+					wgpuRenderPassEncoderSetBindGroup(render_pass, 0, image_data.bindGroup, 0, nullptr);
+				}
 			
-			// Draw the sprite instance
-			wgpuRenderPassEncoderDraw(render_pass, 4, 1, 0, (uint32_t)i);
+				// Draw the sprite instance
+				wgpuRenderPassEncoderDraw(render_pass, 4, 1, 0, (uint32_t)i);
+				renderStats.drawCalls++;
+			}
 		}
 		
 		// End render pass
 		wgpuRenderPassEncoderEnd(render_pass);
 		
 		// Submit commands
-		WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(encoder, nullptr);
-		wgpuQueueSubmit(queue, 1, &command_buffer);
-		
-		// Present
-		wgpuSurfacePresent(surface);
+		WGPUCommandBuffer command_buffer = nullptr;
+		{
+			WILLENGINE_TRACE_ZONE("Graphics::Submit");
+			command_buffer = wgpuCommandEncoderFinish(encoder, nullptr);
+			wgpuQueueSubmit(queue, 1, &command_buffer);
+
+			// Present
+			wgpuSurfacePresent(surface);
+		}
 		
 		// Cleanup
 		wgpuTextureViewRelease(current_texture_view);
@@ -518,23 +556,26 @@ namespace willengine
 
 	void GraphicsManager::DrawWithEditor(const std::function<void(WGPURenderPassEncoder)>& imguiRenderCallback)
 	{
-		// Collect all sprites from the ECS
-		std::vector<Sprite> sprites_to_draw;
-		std::vector<Transform> transforms;
-
-		engine->ecs.ForEach<Sprite, Transform>([&](entityID entity) 
-			{
-			Sprite& sprite = engine->ecs.Get<Sprite>(entity);
-			Transform& transform = engine->ecs.Get<Transform>(entity);
-			sprites_to_draw.emplace_back(sprite);
-			transforms.emplace_back(transform);
-			});
+		renderStats = RenderStats{};
+		if (headless) return;
+		WILLENGINE_TRACE_ZONE("Graphics::DrawWithEditor");
+		// Collect all sprites from the ECS. The list lives in the frame arena, so drawing doesn't touch the heap.
+		FrameVector<SpriteDraw> sprites{ FrameAllocator<SpriteDraw>(&engine->frameArena) };
+		sprites.reserve(engine->ecs.Count<Sprite>());
+
+		{
+			WILLENGINE_TRACE_ZONE("Graphics::Gather");
+			engine->ecs.ForEach<Sprite, Transform>([&](entityID entity) 
+				{
+				sprites.push_back(SpriteDraw{ &engine->ecs.Get<Sprite>(entity), &engine->ecs.Get<Transform>(entity) });
+				});
+		}
 
 		// Sort sprites back-to-front (higher z first)
-		auto sprites = sprites_to_draw;
+		renderStats.sprites = uint32_t(sprites.size());
 		if (!sprites.empty()) {
 			std::sort(sprites.begin(), sprites.end(), 
-				[](const Sprite& lhs, const Sprite& rhs) { return lhs.alpha > rhs.alpha; });
+				[](const SpriteDraw& lhs, const SpriteDraw& rhs) { return lhs.sprite->alpha > rhs.sprite->alpha; });
 
 			// Allocate/reallocate instance buffer if needed
 			if (instance_buffer_capacity < sprites.size()) {
@@ -574,10 +615,10 @@ namespace willengine
 			wgpuRenderPassEncoderSetVertexBuffer(render_pass, 0, vertex_buffer, 0, 4 * 4 * sizeof(float));
 			wgpuRenderPassEncoderSetVertexBuffer(render_pass, 1, instance_buffer, 0, sizeof(InstanceData) * sprites.size());
 
-			std::string current_image = "";
+			const std::string* current_image = nullptr;
 			for (size_t i = 0; i < sprites.size(); ++i) {
-				const Sprite& sprite = sprites[i];
-				const Transform& transform = transforms[i];
+				const Sprite& sprite = *sprites[i].sprite;
+				const Transform& transform = *sprites[i].transform;
 				
 				// Check if texture exists
 				auto it = texturesMap.find(sprite.image);
@@ -605,10 +646,11 @@ namespace willengine
 				
 				// Upload instance data to GPU
 				wgpuQueueWriteBuffer(queue, instance_buffer, i * sizeof(InstanceData), &instance_data, sizeof(InstanceData));
+				renderStats.instanceBytesUploaded += sizeof(InstanceData);
 				
 				// Set bind group if image changed
-				if (sprite.image != current_image) {
-					current_image = sprite.image;
+				if (!current_image || sprite.image != *current_image) {
+					current_image = &sprite.image;
 					
 					// Create bind group if it doesn't exist
 					if (!image_data.bindGroup) {
@@ -643,6 +685,7 @@ namespace willengine
 				
 				// Draw the sprite instance
 				wgpuRenderPassEncoderDraw(render_pass, 4, 1, 0, (uint32_t)i);
+				renderStats.drawCalls++;
 			}
 		}
 		
@@ -655,11 +698,15 @@ namespace willengine
 		wgpuRenderPassEncoderEnd(render_pass);
 		
 		// Submit commands
-		WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(encoder, nullptr);
-		wgpuQueueSubmit(queue, 1, &command_buffer);
-		
-		// Present (only once!)
-		wgpuSurfacePresent(surface);
+		WGPUCommandBuffer command_buffer = nullptr;
+		{
+			WILLENGINE_TRACE_ZONE("Graphics::Submit");
+			command_buffer = wgpuCommandEncoderFinish(encoder, nullptr);
+			wgpuQueueSubmit(queue, 1, &command_buffer);
+
+			// Present (only once!)
+			wgpuSurfacePresent(surface);
+		}
 		
 		// Cleanup
 		wgpuTextureViewRelease(current_texture_view);
@@ -669,9 +716,18 @@ namespace willengine
 		wgpuCommandEncoderRelease(encoder);
 	}
 
+	size_t GraphicsManager::GetTextureBytes() const
+	{
+		size_t bytes = 0;
+		for (const auto& [name, image] : texturesMap) {
+			bytes += size_t(image.width) * size_t(image.height) * 4;
+		}
+		return bytes;
+	}
+
 	bool GraphicsManager::ShouldQuit()
 	{
-		return glfwWindowShouldClose(window);
+		return !headless && glfwWindowShouldClose(window);
 	}
 
 	WGPUTextureFormat GraphicsManager::GetSurfaceFormat() const
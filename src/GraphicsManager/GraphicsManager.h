@@ -29,6 +29,8 @@ namespace willengine
 		void Draw(const std::vector<Sprite>& sprites);
 		void Draw();
 		bool ShouldQuit();
+		// Config::headless: no window and no GPU device, Draw does nothing and textures are only names.
+		bool IsHeadless() const { return headless; }
 
 		GLFWwindow* GetWindow() const { return window; }
 		WGPUDevice GetDevice() const { return device; }
@@ -37,10 +39,23 @@ namespace willengine
 
 		void DrawWithEditor(const std::function<void(WGPURenderPassEncoder)>& imguiRenderCallback);
 
+		// What the last Draw/DrawWithEditor did.
+		struct RenderStats
+		{
+			uint32_t sprites = 0;
+			uint32_t drawCalls = 0;
+			uint64_t instanceBytesUploaded = 0;
+		};
+		const RenderStats& GetRenderStats() const { return renderStats; }
+		size_t GetTextureCount() const { return texturesMap.size(); }
+		// GPU memory of the loaded textures (RGBA8, no mipmaps).
+		size_t GetTextureBytes() const;
+
 	private:
 		Engine* engine;
 		
 		GLFWwindow* window;
+		bool headless = false;
 
 		WGPUInstance instance;
 		WGPUSurface surface;
@@ -54,6 +69,7 @@ namespace willengine
 		WGPUSampler sampler;
 		WGPUBuffer instance_buffer;
 		size_t instance_buffer_capacity;
+		RenderStats renderStats;
 		
 		// Background color
 		double red = 0.1, green = 0.1, blue = 0.1;
@@ -2,42 +2,501 @@
 #include "../Engine.h"
 #include "../GraphicsManager/GraphicsManager.h"
 #include "spdlog/spdlog.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
 
 
 namespace willengine
 {
-	InputManager::InputManager(Engine* engine) : engine(engine)
+	namespace
+	{
+		/*
+			Recording file, little endian:
+				header:	"WEIR", u32 version, f64 tick rate, u64 random seed
+				per tick: u16 flags, then one section per set flag, in flag order
+		*/
+		const char kRecordingMagic[4] = { 'W', 'E', 'I', 'R' };
+		constexpr uint32_t kRecordingVersion = 1;
+
+		enum TickSection : uint16_t
+		{
+			kKeysToggled = 1 << 0,		// u16 count, u16 keys whose down state flipped
+			kKeysPressed = 1 << 1,		// u16 count, u16 keys
+			kKeysReleased = 1 << 2,		// u16 count, u16 keys
+			kMouseButtons = 1 << 3,		// u8 down, u8 pressed, u8 released (bit masks)
+			kMousePosition = 1 << 4,	// f32 x, f32 y
+			kScroll = 1 << 5,			// f32 x, f32 y
+			kGamepad = 1 << 6,			// u16 buttons (bit mask), f32 axes
+			kEvents = 1 << 7,			// u16 count, then u8 type, u16 code, u8 action, f64 time each
+			kStateHash = 1 << 8,		// u64, Engine::GetStateHash after the tick
+		};
+
+		// Values are stored little endian whatever the CPU, so recordings play on any machine.
+		template<typename T>
+		void StoreLittleEndian(uint8_t* bytes, T value)
+		{
+			std::memcpy(bytes, &value, sizeof(T));
+			if constexpr (std::endian::native == std::endian::big) {
+				std::reverse(bytes, bytes + sizeof(T));
+			}
+		}
+
+		template<typename T>
+		void Put(std::vector<uint8_t>& out, T value)
+		{
+			const size_t at = out.size();
+			out.resize(at + sizeof(T));
+			StoreLittleEndian(out.data() + at, value);
+		}
+
+		template<typename T>
+		bool Take(const std::vector<uint8_t>& in, size_t& cursor, T& value)
+		{
+			if (in.size() - cursor < sizeof(T)) return false;
+			uint8_t bytes[sizeof(T)];
+			std::memcpy(bytes, in.data() + cursor, sizeof(T));
+			if constexpr (std::endian::native == std::endian::big) {
+				std::reverse(bytes, bytes + sizeof(T));
+			}
+			std::memcpy(&value, bytes, sizeof(T));
+			cursor += sizeof(T);
+			return true;
+		}
+
+		bool TakeHeader(const std::vector<uint8_t>& in, size_t& cursor, double& tickRate, uint64_t& randomSeed)
+		{
+			char magic[4] = {};
+			uint32_t version = 0;
+			for (char& c : magic) {
+				if (!Take(in, cursor, c)) return false;
+			}
+			return std::memcmp(magic, kRecordingMagic, sizeof(magic)) == 0 && Take(in, cursor, version) && version == kRecordingVersion
+				&& Take(in, cursor, tickRate) && Take(in, cursor, randomSeed);
+		}
+
+		template<size_t N>
+		void PutKeys(std::vector<uint8_t>& out, const std::bitset<N>& keys)
+		{
+			Put<uint16_t>(out, uint16_t(keys.count()));
+			for (size_t key = 0; key < N; ++key) {
+				if (keys.test(key)) Put<uint16_t>(out, uint16_t(key));
+			}
+		}
+
+		template<size_t N>
+		bool TakeKeys(const std::vector<uint8_t>& in, size_t& cursor, std::bitset<N>& keys, bool toggle)
+		{
+			uint16_t count;
+			if (!Take(in, cursor, count)) return false;
+			for (uint16_t i = 0; i < count; ++i) {
+				uint16_t key;
+				if (!Take(in, cursor, key) || key >= N) return false;
+				if (toggle) keys.flip(key);
+				else keys.set(key);
+			}
+			return true;
+		}
+	}
+
+	InputManager::InputManager(Engine* engine) : engine(engine), gamepadAxes{}, recordedGamepadAxes{}
 	{
 	}
 
 	InputManager::~InputManager()
 	{
 	}
-	void InputManager::Update()
+
+	void InputManager::Startup()
 	{
-		prevFrameKeyStates[W] = glfwGetKey(engine->graphics->window, W);
-		prevFrameKeyStates[A] = glfwGetKey(engine->graphics->window, A);
-		prevFrameKeyStates[S] = glfwGetKey(engine->graphics->window, S);
-		prevFrameKeyStates[D] = glfwGetKey(engine->graphics->window, D);
-		prevFrameKeyStates[SPACE] = glfwGetKey(engine->graphics->window, SPACE);
-		prevFrameKeyStates[ESC] = glfwGetKey(engine->graphics->window, ESC);
+		GLFWwindow* window = engine->graphics->window;
+		if (!window) return;
 
+		// ImGui's GLFW backend is initialized later and chains these callbacks, so both keep working.
+		glfwSetWindowUserPointer(window, this);
+		glfwSetKeyCallback(window, &InputManager::KeyCallback);
+		glfwSetMouseButtonCallback(window, &InputManager::MouseButtonCallback);
+		glfwSetCursorPosCallback(window, &InputManager::CursorPosCallback);
+		glfwSetScrollCallback(window, &InputManager::ScrollCallback);
+
+		pendingEvents.reserve(64);
+		tickEvents.reserve(64);
+	}
+
+	void InputManager::KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+	{
+		InputManager* input = static_cast<InputManager*>(glfwGetWindowUserPointer(window));
+		if (!input || key < 0 || key >= kKeyCount) return;
+
+		if (action == GLFW_PRESS) {
+			input->liveKeys.set(key);
+			input->keysPressedSinceTick.set(key);
+		}
+		else if (action == GLFW_RELEASE) {
+			input->liveKeys.reset(key);
+			input->keysReleasedSinceTick.set(key);
+		}
+		input->pendingEvents.push_back({ InputEvent::Type::Key, key, action, glfwGetTime() });
+	}
+
+	void InputManager::MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+	{
+		InputManager* input = static_cast<InputManager*>(glfwGetWindowUserPointer(window));
+		if (!input || button < 0 || button >= kMouseButtonCount) return;
+
+		if (action == GLFW_PRESS) {
+			input->liveButtons.set(button);
+			input->buttonsPressedSinceTick.set(button);
+		}
+		else if (action == GLFW_RELEASE) {
+			input->liveButtons.reset(button);
+			input->buttonsReleasedSinceTick.set(button);
+		}
+		input->pendingEvents.push_back({ InputEvent::Type::MouseButton, button, action, glfwGetTime() });
+	}
+
+	void InputManager::CursorPosCallback(GLFWwindow* window, double x, double y)
+	{
+		InputManager* input = static_cast<InputManager*>(glfwGetWindowUserPointer(window));
+		if (!input) return;
+		input->liveMousePosition = vec2((float)x, (float)y);
+	}
+
+	void InputManager::ScrollCallback(GLFWwindow* window, double x, double y)
+	{
+		InputManager* input = static_cast<InputManager*>(glfwGetWindowUserPointer(window));
+		if (!input) return;
+		input->scrollSinceTick += vec2((float)x, (float)y);
+	}
+
+	void InputManager::PollEvents()
+	{
 		glfwPollEvents();
 	}
-	bool InputManager::KeyIsPressedInFrame(Key key)
+
+	void InputManager::Update()
 	{
-		return glfwGetKey(engine->graphics->window, key) == GLFW_PRESS;
+		if (replaying) {
+			// The window stays responsive, but what it received is dropped: this tick comes from the file.
+			keysPressedSinceTick.reset();
+			keysReleasedSinceTick.reset();
+			buttonsPressedSinceTick.reset();
+			buttonsReleasedSinceTick.reset();
+			scrollSinceTick = vec2(0.0f, 0.0f);
+			pendingEvents.clear();
+			if (ReplayTick()) return;
+			FinishReplay();	// truncated or corrupt: the rest of this tick runs on live input
+		}
+
+		// A key tapped and released between two ticks still reads as down (and just pressed) for one tick.
+		keysDown = liveKeys | keysPressedSinceTick;
+		keysPressed = keysPressedSinceTick;
+		keysReleased = keysReleasedSinceTick;
+		keysPressedSinceTick.reset();
+		keysReleasedSinceTick.reset();
+
+		buttonsDown = liveButtons | buttonsPressedSinceTick;
+		buttonsPressed = buttonsPressedSinceTick;
+		buttonsReleased = buttonsReleasedSinceTick;
+		buttonsPressedSinceTick.reset();
+		buttonsReleasedSinceTick.reset();
+
+		mousePosition = liveMousePosition;
+		scrollDelta = scrollSinceTick;
+		scrollSinceTick = vec2(0.0f, 0.0f);
+
+		tickEvents.swap(pendingEvents);
+		pendingEvents.clear();
+
+		prevGamepadButtons = gamepadButtons;
+		gamepadButtons.reset();
+		GLFWgamepadstate state;
+		if (glfwJoystickIsGamepad(GLFW_JOYSTICK_1) && glfwGetGamepadState(GLFW_JOYSTICK_1, &state)) {
+			for (int i = 0; i < kGamepadButtonCount; ++i) {
+				gamepadButtons[i] = state.buttons[i] == GLFW_PRESS;
+			}
+			for (int i = 0; i < kGamepadAxisCount; ++i) {
+				gamepadAxes[i] = state.axes[i];
+			}
+		}
+		else {
+			for (float& axis : gamepadAxes) axis = 0.0f;
+		}
 	}
-	bool InputManager::KeyJustPressed(Key key)
+
+	bool InputManager::KeyIsPressedInFrame(int key) const
 	{
-		int currentState = glfwGetKey(engine->graphics->window, key);
-		return prevFrameKeyStates[key] == GLFW_RELEASE && currentState == GLFW_PRESS;
+		return key >= 0 && key < kKeyCount && keysDown.test(key);
 	}
 
-	bool InputManager::KeyJustReleased(Key key)
+	bool InputManager::KeyJustPressed(int key) const
 	{
-		int currentState = glfwGetKey(engine->graphics->window, key);
-		return prevFrameKeyStates[key] == GLFW_PRESS && currentState == GLFW_RELEASE;
+		return key >= 0 && key < kKeyCount && keysPressed.test(key);
 	}
-}
 
+	bool InputManager::KeyJustReleased(int key) const
+	{
+		return key >= 0 && key < kKeyCount && keysReleased.test(key);
+	}
+
+	bool InputManager::MouseButtonIsPressed(int button) const
+	{
+		return button >= 0 && button < kMouseButtonCount && buttonsDown.test(button);
+	}
+
+	bool InputManager::MouseButtonJustPressed(int button) const
+	{
+		return button >= 0 && button < kMouseButtonCount && buttonsPressed.test(button);
+	}
+
+	bool InputManager::MouseButtonJustReleased(int button) const
+	{
+		return button >= 0 && button < kMouseButtonCount && buttonsReleased.test(button);
+	}
+
+	bool InputManager::GamepadButtonIsPressed(int button) const
+	{
+		return button >= 0 && button < kGamepadButtonCount && gamepadButtons.test(button);
+	}
+
+	bool InputManager::GamepadButtonJustPressed(int button) const
+	{
+		return button >= 0 && button < kGamepadButtonCount && gamepadButtons.test(button) && !prevGamepadButtons.test(button);
+	}
+
+	float InputManager::GetGamepadAxis(int axis) const
+	{
+		return axis >= 0 && axis < kGamepadAxisCount ? gamepadAxes[axis] : 0.0f;
+	}
+
+	bool InputManager::StartRecording(const std::string& path)
+	{
+		StopRecording();
+		recordFile.open(path, std::ios::binary | std::ios::trunc);
+		if (!recordFile) {
+			spdlog::error("Failed to open input recording '{}'", path);
+			return false;
+		}
+
+		const Engine::Config& config = engine->BringEngineConfiguration();
+		recordBuffer.clear();
+		recordBuffer.insert(recordBuffer.end(), std::begin(kRecordingMagic), std::end(kRecordingMagic));
+		Put<uint32_t>(recordBuffer, kRecordingVersion);
+		Put<double>(recordBuffer, config.tick_rate);
+		Put<uint64_t>(recordBuffer, config.random_seed);
+		recordFile.write(reinterpret_cast<const char*>(recordBuffer.data()), std::streamsize(recordBuffer.size()));
+
+		// Everything starts out released, the first tick writes what is already held.
+		recordedKeysDown.reset();
+		recordedButtonsDown.reset();
+		recordedGamepadButtons.reset();
+		for (float& axis : recordedGamepadAxes) axis = 0.0f;
+		recordedMousePosition = vec2(0.0f, 0.0f);
+		spdlog::info("Recording input to '{}'", path);
+		return true;
+	}
+
+	void InputManager::StopRecording()
+	{
+		if (recordFile.is_open()) {
+			recordFile.close();
+		}
+	}
+
+	bool InputManager::StartReplay(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			spdlog::error("Failed to open input recording '{}'", path);
+			return false;
+		}
+		replayData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+		double tickRate = 0.0;
+		uint64_t seed = 0;
+		replayCursor = 0;
+		if (!TakeHeader(replayData, replayCursor, tickRate, seed)) {
+			spdlog::error("'{}' is not an input recording this engine can read", path);
+			replayData.clear();
+			return false;
+		}
+
+		const Engine::Config& config = engine->BringEngineConfiguration();
+		if (tickRate != config.tick_rate || seed != config.random_seed) {
+			spdlog::warn("'{}' was recorded at {} ticks/s with seed {}, replaying at {} ticks/s with seed {}: the run may differ",
+				path, tickRate, seed, config.tick_rate, config.random_seed);
+		}
+
+		// Replay starts from nothing held, like the recording did.
+		keysDown.reset();
+		buttonsDown.reset();
+		gamepadButtons.reset();
+		for (float& axis : gamepadAxes) axis = 0.0f;
+		replaying = true;
+		replayFinished = false;
+		replayHasHash = false;
+		replayTick = 0;
+		replayDivergence = -1;
+		spdlog::info("Replaying input from '{}'", path);
+		return true;
+	}
+
+	bool InputManager::ReadRecordingHeader(const std::string& path, double& tickRate, uint64_t& randomSeed)
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::vector<uint8_t> header(4 + sizeof(uint32_t) + sizeof(double) + sizeof(uint64_t));
+		if (!file.read(reinterpret_cast<char*>(header.data()), std::streamsize(header.size()))) return false;
+		size_t cursor = 0;
+		return TakeHeader(header, cursor, tickRate, randomSeed);
+	}
+
+	void InputManager::EndTick()
+	{
+		if (recordFile.is_open()) {
+			RecordTick();
+		}
+		if (replaying) {
+			if (replayHasHash && engine->BringEngineConfiguration().deterministic && replayDivergence < 0 && engine->GetStateHash() != replayHash) {
+				replayDivergence = int64_t(replayTick);
+				spdlog::error("Replay diverged from the recording at tick {}", replayTick);
+			}
+			replayTick++;
+			// Finished as soon as the last recorded tick has run, so the engine stops before ticking past it.
+			if (replayCursor == replayData.size()) {
+				FinishReplay();
+			}
+		}
+	}
+
+	void InputManager::FinishReplay()
+	{
+		replaying = false;
+		replayFinished = true;
+		replayHasHash = false;
+		replayData.clear();
+		replayData.shrink_to_fit();
+		spdlog::info("Replay finished after {} ticks", replayTick);
+	}
+
+	void InputManager::RecordTick()
+	{
+		recordBuffer.clear();
+		Put<uint16_t>(recordBuffer, 0);	// flags, filled in below
+		uint16_t flags = 0;
+
+		const std::bitset<kKeyCount> toggled = keysDown ^ recordedKeysDown;
+		if (toggled.any()) {
+			flags |= kKeysToggled;
+			PutKeys(recordBuffer, toggled);
+			recordedKeysDown = keysDown;
+		}
+		if (keysPressed.any()) {
+			flags |= kKeysPressed;
+			PutKeys(recordBuffer, keysPressed);
+		}
+		if (keysReleased.any()) {
+			flags |= kKeysReleased;
+			PutKeys(recordBuffer, keysReleased);
+		}
+		if (buttonsDown != recordedButtonsDown || buttonsPressed.any() || buttonsReleased.any()) {
+			flags |= kMouseButtons;
+			Put<uint8_t>(recordBuffer, uint8_t(buttonsDown.to_ulong()));
+			Put<uint8_t>(recordBuffer, uint8_t(buttonsPressed.to_ulong()));
+			Put<uint8_t>(recordBuffer, uint8_t(buttonsReleased.to_ulong()));
+			recordedButtonsDown = buttonsDown;
+		}
+		if (mousePosition != recordedMousePosition) {
+			flags |= kMousePosition;
+			Put<float>(recordBuffer, mousePosition.x);
+			Put<float>(recordBuffer, mousePosition.y);
+			recordedMousePosition = mousePosition;
+		}
+		if (scrollDelta != vec2(0.0f, 0.0f)) {
+			flags |= kScroll;
+			Put<float>(recordBuffer, scrollDelta.x);
+			Put<float>(recordBuffer, scrollDelta.y);
+		}
+		if (gamepadButtons != recordedGamepadButtons || std::memcmp(gamepadAxes, recordedGamepadAxes, sizeof(gamepadAxes)) != 0) {
+			flags |= kGamepad;
+			Put<uint16_t>(recordBuffer, uint16_t(gamepadButtons.to_ulong()));
+			for (float axis : gamepadAxes) Put<float>(recordBuffer, axis);
+			recordedGamepadButtons = gamepadButtons;
+			std::memcpy(recordedGamepadAxes, gamepadAxes, sizeof(gamepadAxes));
+		}
+		if (!tickEvents.empty()) {
+			flags |= kEvents;
+			Put<uint16_t>(recordBuffer, uint16_t(std::min<size_t>(tickEvents.size(), 0xFFFF)));
+			for (size_t i = 0; i < tickEvents.size() && i < 0xFFFF; ++i) {
+				const InputEvent& event = tickEvents[i];
+				Put<uint8_t>(recordBuffer, uint8_t(event.type));
+				Put<uint16_t>(recordBuffer, uint16_t(event.code));
+				Put<uint8_t>(recordBuffer, uint8_t(event.action));
+				Put<double>(recordBuffer, event.time);
+			}
+		}
+		if (engine->BringEngineConfiguration().deterministic) {
+			flags |= kStateHash;
+			Put<uint64_t>(recordBuffer, engine->GetStateHash());
+		}
+
+		StoreLittleEndian(recordBuffer.data(), flags);
+		recordFile.write(reinterpret_cast<const char*>(recordBuffer.data()), std::streamsize(recordBuffer.size()));
+	}
+
+	bool InputManager::ReplayTick()
+	{
+		uint16_t flags;
+		if (!Take(replayData, replayCursor, flags)) return false;	// end of the recording
+
+		keysPressed.reset();
+		keysReleased.reset();
+		buttonsPressed.reset();
+		buttonsReleased.reset();
+		scrollDelta = vec2(0.0f, 0.0f);
+		tickEvents.clear();
+		prevGamepadButtons = gamepadButtons;
+		replayHasHash = false;
+
+		bool ok = true;
+		if (flags & kKeysToggled) ok = ok && TakeKeys(replayData, replayCursor, keysDown, true);
+		if (flags & kKeysPressed) ok = ok && TakeKeys(replayData, replayCursor, keysPressed, false);
+		if (flags & kKeysReleased) ok = ok && TakeKeys(replayData, replayCursor, keysReleased, false);
+		if (flags & kMouseButtons) {
+			uint8_t down = 0, pressed = 0, released = 0;
+			ok = ok && Take(replayData, replayCursor, down) && Take(replayData, replayCursor, pressed) && Take(replayData, replayCursor, released);
+			buttonsDown = std::bitset<kMouseButtonCount>(down);
+			buttonsPressed = std::bitset<kMouseButtonCount>(pressed);
+			buttonsReleased = std::bitset<kMouseButtonCount>(released);
+		}
+		if (flags & kMousePosition) ok = ok && Take(replayData, replayCursor, mousePosition.x) && Take(replayData, replayCursor, mousePosition.y);
+		if (flags & kScroll) ok = ok && Take(replayData, replayCursor, scrollDelta.x) && Take(replayData, replayCursor, scrollDelta.y);
+		if (flags & kGamepad) {
+			uint16_t buttons = 0;
+			ok = ok && Take(replayData, replayCursor, buttons);
+			gamepadButtons = std::bitset<kGamepadButtonCount>(buttons);
+			for (float& axis : gamepadAxes) ok = ok && Take(replayData, replayCursor, axis);
+		}
+		if (flags & kEvents) {
+			uint16_t count = 0;
+			ok = ok && Take(replayData, replayCursor, count);
+			for (uint16_t i = 0; ok && i < count; ++i) {
+				uint8_t type = 0, action = 0;
+				uint16_t code = 0;
+				double time = 0.0;
+				ok = Take(replayData, replayCursor, type) && Take(replayData, replayCursor, code) && Take(replayData, replayCursor, action) && Take(replayData, replayCursor, time);
+				tickEvents.push_back({ InputEvent::Type(type), int(code), int(action), time });
+			}
+		}
+		if (flags & kStateHash) {
+			ok = ok && Take(replayData, replayCursor, replayHash);
+			replayHasHash = ok;
+		}
+
+		if (!ok) {
+			spdlog::error("Input recording is truncated or corrupt at tick {}", replayTick);
+			return false;
+		}
+		return true;
+	}
+}
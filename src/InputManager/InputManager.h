@@ -1,11 +1,20 @@
 #pragma once
-#include <unordered_map>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <fstream>
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
+#include "../Types.h"
+
 namespace willengine
 {
 	class Engine;
 	class InputManager
 	{
 		public:
+			// Common keys. Any GLFW key code can be queried, these are just named shortcuts.
 			enum Key 
 			{
 				W = 87,
@@ -15,15 +24,125 @@ namespace willengine
 				SPACE = 32,
 				ESC = 256
 			};
+
+			// Raw input as it arrived from GLFW, timestamped with glfwGetTime().
+			struct InputEvent
+			{
+				enum class Type : uint8_t { Key, MouseButton };
+				Type type;
+				int code;		// key or mouse button
+				int action;		// GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+				double time;
+			};
+
+			static constexpr int kKeyCount = GLFW_KEY_LAST + 1;
+			static constexpr int kMouseButtonCount = GLFW_MOUSE_BUTTON_LAST + 1;
+			static constexpr int kGamepadButtonCount = GLFW_GAMEPAD_BUTTON_LAST + 1;
+			static constexpr int kGamepadAxisCount = GLFW_GAMEPAD_AXIS_LAST + 1;
+
 			InputManager(Engine* engine);
 			~InputManager();
+
+			// Installs the GLFW callbacks. Needs the window, so call it after GraphicsManager::Startup.
+			void Startup();
+
+			// Pumps the window's events; the callbacks fill the live state. Once per frame, whether or not a tick runs,
+			// so closing, resizing and input aren't held back on frames without ticks.
+			void PollEvents();
+			// Takes this tick's snapshot of the live state. All queries below read that snapshot, so they're plain bit tests.
 			void Update();
-			bool KeyIsPressedInFrame(Key key);
-			bool KeyJustReleased(Key key);
-			bool KeyJustPressed(Key key);
+
+			bool KeyIsPressedInFrame(int key) const;
+			bool KeyJustReleased(int key) const;
+			bool KeyJustPressed(int key) const;
+
+			bool MouseButtonIsPressed(int button) const;
+			bool MouseButtonJustPressed(int button) const;
+			bool MouseButtonJustReleased(int button) const;
+			vec2 GetMousePosition() const { return mousePosition; }
+			vec2 GetScrollDelta() const { return scrollDelta; }
+
+			// First connected gamepad (GLFW has no gamepad callbacks, it's sampled once per tick).
+			bool GamepadButtonIsPressed(int button) const;
+			bool GamepadButtonJustPressed(int button) const;
+			float GetGamepadAxis(int axis) const;
+
+			// Every key/mouse event that arrived since the previous tick, in order.
+			const std::vector<InputEvent>& GetEventsThisTick() const { return tickEvents; }
+
+			/*
+				Recording and replay. A recording holds every tick's snapshot (only what changed since the
+				previous tick) plus the state hash when the engine is deterministic. While replaying, Update
+				reads the next tick from the file instead of GLFW, so the game sees exactly the recorded input.
+			*/
+			bool StartRecording(const std::string& path);
+			void StopRecording();
+			bool IsRecording() const { return recordFile.is_open(); }
+			bool StartReplay(const std::string& path);
+			// Tick rate and random seed the recording was made with, to replay it under the same settings.
+			static bool ReadRecordingHeader(const std::string& path, double& tickRate, uint64_t& randomSeed);
+			bool IsReplaying() const { return replaying; }
+			// Every recorded tick has been played. Set by the EndTick of the last one.
+			bool IsReplayFinished() const { return replayFinished; }
+			// First replayed tick whose state hash didn't match the recording, -1 if none (or nothing to compare).
+			int64_t GetReplayDivergence() const { return replayDivergence; }
+			// Called by the engine once the tick's simulation is done: writes the tick, or checks its hash.
+			void EndTick();
 
 		private:
+			void RecordTick();
+			bool ReplayTick();
+			void FinishReplay();
+
+			static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+			static void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+			static void CursorPosCallback(GLFWwindow* window, double x, double y);
+			static void ScrollCallback(GLFWwindow* window, double x, double y);
+
 			Engine* engine;
-			std::unordered_map<Key, int> prevFrameKeyStates;
+
+			// Live state, written by the callbacks while glfwPollEvents runs.
+			std::bitset<kKeyCount> liveKeys;
+			std::bitset<kKeyCount> keysPressedSinceTick;
+			std::bitset<kKeyCount> keysReleasedSinceTick;
+			std::bitset<kMouseButtonCount> liveButtons;
+			std::bitset<kMouseButtonCount> buttonsPressedSinceTick;
+			std::bitset<kMouseButtonCount> buttonsReleasedSinceTick;
+			vec2 liveMousePosition;
+			vec2 scrollSinceTick;
+			std::vector<InputEvent> pendingEvents;
+
+			// Snapshot of the current tick.
+			std::bitset<kKeyCount> keysDown;
+			std::bitset<kKeyCount> keysPressed;
+			std::bitset<kKeyCount> keysReleased;
+			std::bitset<kMouseButtonCount> buttonsDown;
+			std::bitset<kMouseButtonCount> buttonsPressed;
+			std::bitset<kMouseButtonCount> buttonsReleased;
+			std::bitset<kGamepadButtonCount> gamepadButtons;
+			std::bitset<kGamepadButtonCount> prevGamepadButtons;
+			float gamepadAxes[kGamepadAxisCount];
+			vec2 mousePosition;
+			vec2 scrollDelta;
+			std::vector<InputEvent> tickEvents;
+
+			// Recording: what the file already says, so only changes get written.
+			std::ofstream recordFile;
+			std::vector<uint8_t> recordBuffer;
+			std::bitset<kKeyCount> recordedKeysDown;
+			std::bitset<kMouseButtonCount> recordedButtonsDown;
+			std::bitset<kGamepadButtonCount> recordedGamepadButtons;
+			float recordedGamepadAxes[kGamepadAxisCount];
+			vec2 recordedMousePosition;
+
+			// Replay: the whole file, read as ticks go by.
+			std::vector<uint8_t> replayData;
+			size_t replayCursor = 0;
+			bool replaying = false;
+			bool replayFinished = false;
+			bool replayHasHash = false;
+			uint64_t replayHash = 0;
+			uint64_t replayTick = 0;
+			int64_t replayDivergence = -1;
 	};
 }
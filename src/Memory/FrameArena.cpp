@@ -0,0 +1,69 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace willengine
+{
+	FrameArena::FrameArena(size_t initialBytes)
+		: owner(std::this_thread::get_id())
+	{
+		for (Buffer& buffer : buffers) {
+			AddBlock(buffer, initialBytes);
+		}
+	}
+
+	void* FrameArena::Allocate(size_t bytes, size_t alignment)
+	{
+		Buffer& buffer = buffers[current];
+		for (;;)
+		{
+			Block& block = buffer.blocks[buffer.block];
+			const uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+			const uintptr_t aligned = (base + buffer.offset + alignment - 1) & ~uintptr_t(alignment - 1);
+			const size_t end = size_t(aligned - base) + bytes;
+			if (end <= block.size) {
+				buffer.used += end - buffer.offset;
+				buffer.offset = end;
+				return reinterpret_cast<void*>(aligned);
+			}
+
+			// Doesn't fit: on to the next block, taking a new one if this was the last.
+			buffer.block++;
+			buffer.offset = 0;
+			if (buffer.block == buffer.blocks.size()) {
+				AddBlock(buffer, std::max(block.size * 2, bytes + alignment));
+			}
+		}
+	}
+
+	void FrameArena::EndFrame()
+	{
+		current = 1 - current;
+		Buffer& buffer = buffers[current];
+
+		// This buffer overflowed into more blocks: replace them by one that holds it all.
+		if (buffer.blocks.size() > 1) {
+			const size_t capacity = buffer.Capacity();
+			buffer.blocks.clear();
+			AddBlock(buffer, capacity);
+		}
+		buffer.block = 0;
+		buffer.offset = 0;
+		buffer.used = 0;
+	}
+
+	size_t FrameArena::Buffer::Capacity() const
+	{
+		size_t capacity = 0;
+		for (const Block& block : blocks) {
+			capacity += block.size;
+		}
+		return capacity;
+	}
+
+	void FrameArena::AddBlock(Buffer& buffer, size_t size)
+	{
+		buffer.blocks.push_back(Block{ std::make_unique<std::byte[]>(size), size });
+		heapAllocations++;
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace willengine
+{
+	/*
+		Linear allocator for memory that only lives for a frame. Allocating bumps a pointer, freeing does nothing,
+		and EndFrame() takes everything back at once. It is double-buffered: what frame N allocated stays valid
+		through frame N + 1 and is reused in frame N + 2, so data can be handed to the next frame.
+		When a frame needs more than the arena holds, another block is taken from the heap; the next reset of
+		that buffer merges its blocks into one, so a steady frame does no heap allocation at all.
+		Not thread-safe: one thread uses it at a time. The engine's arena belongs to the main thread; each
+		parallel script state has its own for the writes it queues, handed to the main thread for the replay.
+	*/
+	class FrameArena
+	{
+	public:
+		explicit FrameArena(size_t initialBytes = 256 * 1024);
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		void* Allocate(size_t bytes, size_t alignment);
+
+		// Called once per frame by the engine loops. Makes the older buffer current and empties it.
+		void EndFrame();
+
+		bool IsOwnerThread() const { return std::this_thread::get_id() == owner; }
+
+		size_t GetBytesUsed() const { return buffers[current].used; }
+		size_t GetCapacity() const { return buffers[0].Capacity() + buffers[1].Capacity(); }
+		// Blocks taken from the heap since startup. Stops growing once the arena has seen the largest frame.
+		size_t GetHeapAllocations() const { return heapAllocations; }
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<std::byte[]> memory;
+			size_t size = 0;
+		};
+
+		struct Buffer
+		{
+			std::vector<Block> blocks;
+			size_t block = 0;		// block being filled
+			size_t offset = 0;		// into that block
+			size_t used = 0;		// bytes handed out this frame, padding included
+			size_t Capacity() const;
+		};
+
+		void AddBlock(Buffer& buffer, size_t size);
+
+		Buffer buffers[2];
+		int current = 0;
+		size_t heapAllocations = 0;
+		std::thread::id owner;
+	};
+
+	// STL allocator on a FrameArena, or on the heap when the arena is null. deallocate() is a no-op on an arena,
+	// so reserve() containers up front where the size is known: growing leaves the old storage behind until reset.
+	template<typename T>
+	class FrameAllocator
+	{
+	public:
+		using value_type = T;
+
+		FrameAllocator(FrameArena* arena = nullptr) noexcept : arena(arena) {}
+		template<typename U>
+		FrameAllocator(const FrameAllocator<U>& other) noexcept : arena(other.arena) {}
+
+		T* allocate(size_t count)
+		{
+			if (!arena) return std::allocator<T>().allocate(count);
+			return static_cast<T*>(arena->Allocate(count * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T* pointer, size_t count) noexcept
+		{
+			if (!arena) std::allocator<T>().deallocate(pointer, count);
+		}
+
+		template<typename U>
+		bool operator==(const FrameAllocator<U>& other) const noexcept { return arena == other.arena; }
+		template<typename U>
+		bool operator!=(const FrameAllocator<U>& other) const noexcept { return arena != other.arena; }
+
+		FrameArena* arena;
+	};
+
+	template<typename T>
+	using FrameVector = std::vector<T, FrameAllocator<T>>;
+}
@@ -0,0 +1,115 @@
+#include "Metrics.h"
+#include "../Engine.h"
+#include "../GraphicsManager/GraphicsManager.h"
+#include "../ScriptManager/ScriptManager.h"
+#include "../SoundManager/SoundManager.h"
+#include <algorithm>
+
+namespace willengine
+{
+	namespace
+	{
+		template<typename... Ts>
+		void CountPools(ECS& ecs, std::vector<ComponentPoolCount>& pools, std::tuple<Ts...>*)
+		{
+			pools.clear();
+			(pools.push_back(ComponentPoolCount{ ComponentName<Ts>, ecs.Count<Ts>() }), ...);
+		}
+	}
+
+	Metrics::Metrics(Engine* engine)
+		: engine(engine),
+		  frameTimes(kFrameWindow, 0.0f),
+		  histogram(kHistogramBuckets, 0.0f)
+	{
+		sortScratch.reserve(kFrameWindow);
+	}
+
+	void Metrics::AddTick(const TickTimings& timings)
+	{
+		current.ticks++;
+		current.systems.input += timings.input;
+		current.systems.scripts += timings.scripts;
+		current.systems.callback += timings.callback;
+		current.systems.physics += timings.physics;
+		current.systems.collisionEvents += timings.collisionEvents;
+	}
+
+	void Metrics::EndFrame(double drawMs)
+	{
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (started) {
+			const float frameMs = std::chrono::duration<float, std::milli>(now - lastFrameEnd).count();
+			if (frameCount == kFrameWindow) {
+				histogram[BucketOf(frameTimes[nextFrame])] -= 1.0f;
+			}
+			else {
+				frameCount++;
+			}
+			frameTimes[nextFrame] = frameMs;
+			histogram[BucketOf(frameMs)] += 1.0f;
+			nextFrame = (nextFrame + 1) % kFrameWindow;
+			current.frameMs = frameMs;
+		}
+		started = true;
+		lastFrameEnd = now;
+
+		current.drawMs = drawMs;
+		current.luaGCMs = engine->script->GetGCStats().lastFrameMs;
+		CountPools(engine->ecs, current.pools, static_cast<ComponentTypes*>(nullptr));
+
+		const GraphicsManager::RenderStats& render = engine->graphics->GetRenderStats();
+		current.sprites = render.sprites;
+		current.drawCalls = render.drawCalls;
+		current.instanceBytesUploaded = render.instanceBytesUploaded;
+		current.textureCount = engine->graphics->GetTextureCount();
+		current.textureBytes = engine->graphics->GetTextureBytes();
+		current.soundCount = engine->sound->GetSoundCount();
+		current.soundBytes = engine->sound->GetSoundBytes();
+		current.frameArenaBytes = engine->frameArena.GetBytesUsed();
+		current.frameArenaCapacity = engine->frameArena.GetCapacity();
+		current.frameArenaHeapAllocations = engine->frameArena.GetHeapAllocations();
+
+		// Swap rather than copy, so the pools vector keeps its capacity.
+		std::swap(stats, current);
+		UpdatePercentiles();
+		current.ticks = 0;
+		current.systems = TickTimings{};
+	}
+
+	Metrics::FrameTimeRing Metrics::GetFrameTimes() const
+	{
+		// Until the window is full the ring hasn't wrapped, and the frames start at 0.
+		return FrameTimeRing{ frameTimes.data(), frameCount, frameCount == kFrameWindow ? nextFrame : 0 };
+	}
+
+	void Metrics::SetCounter(const std::string& name, double value)
+	{
+		for (auto& [counterName, counterValue] : counters) {
+			if (counterName == name) {
+				counterValue = value;
+				return;
+			}
+		}
+		counters.emplace_back(name, value);
+	}
+
+	size_t Metrics::BucketOf(float milliseconds)
+	{
+		const size_t bucket = size_t(std::max(milliseconds, 0.0f) / kHistogramBucketMs);
+		return std::min(bucket, kHistogramBuckets - 1);
+	}
+
+	void Metrics::UpdatePercentiles()
+	{
+		if (frameCount == 0) return;
+		// 600 floats: sorting a copy every frame is cheaper than keeping an order statistic tree.
+		sortScratch.assign(frameTimes.begin(), frameTimes.begin() + frameCount);
+		std::sort(sortScratch.begin(), sortScratch.end());
+		auto percentile = [&](double p) { return double(sortScratch[size_t(p * (frameCount - 1) + 0.5)]); };
+		stats.p50Ms = percentile(0.50);
+		stats.p95Ms = percentile(0.95);
+		stats.p99Ms = percentile(0.99);
+		stats.maxMs = sortScratch.back();
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace willengine
+{
+	class Engine;
+
+	// Wall time of each stage of a tick, in milliseconds.
+	struct TickTimings
+	{
+		double input = 0.0;
+		double scripts = 0.0;
+		double callback = 0.0;
+		double physics = 0.0;
+		double collisionEvents = 0.0;	// OnCollision dispatch
+	};
+
+	// How many entities hold one component type.
+	struct ComponentPoolCount
+	{
+		const char* component = nullptr;	// ComponentName<T>
+		size_t count = 0;
+	};
+
+	// Engine numbers for one frame, see Metrics::GetFrameStats.
+	struct FrameStats
+	{
+		// Frame time: the last frame, and percentiles over the last Metrics::kFrameWindow frames.
+		double frameMs = 0.0;
+		double p50Ms = 0.0;
+		double p95Ms = 0.0;
+		double p99Ms = 0.0;
+		double maxMs = 0.0;
+
+		// Simulation ticks run this frame, and their stage timings summed.
+		uint32_t ticks = 0;
+		TickTimings systems;
+		double drawMs = 0.0;
+		double luaGCMs = 0.0;
+
+		std::vector<ComponentPoolCount> pools;
+
+		// Renderer, last Draw
+		uint32_t sprites = 0;
+		uint32_t drawCalls = 0;
+		uint64_t instanceBytesUploaded = 0;
+
+		// Loaded assets
+		size_t textureCount = 0;
+		size_t textureBytes = 0;	// GPU memory, RGBA8
+		size_t soundCount = 0;
+		size_t soundBytes = 0;		// decoded samples; streamed sounds count as 0
+
+		// Frame arena: scratch used this frame, its capacity, and heap blocks it has taken since startup
+		size_t frameArenaBytes = 0;
+		size_t frameArenaCapacity = 0;
+		size_t frameArenaHeapAllocations = 0;
+	};
+
+	// Frame statistics, collected by the engine loops. Reading them is cheap, so an overlay can do it every frame.
+	class Metrics
+	{
+	public:
+		static constexpr size_t kFrameWindow = 600;			// 10 seconds at 60 fps
+		static constexpr size_t kHistogramBuckets = 34;		// 0.5 ms wide up to 16.5 ms, the last one takes the rest
+		static constexpr double kHistogramBucketMs = 0.5;
+
+		Metrics(Engine* engine);
+
+		// Called by Engine::Tick after every tick.
+		void AddTick(const TickTimings& timings);
+		// Called by the engine loops once per frame, after drawing. Samples the counters and starts the next frame.
+		void EndFrame(double drawMs);
+
+		// The last kFrameWindow frame times in milliseconds, as the ring buffer they are kept in (no copy):
+		// `count` values, the oldest at `values[oldest]`. Matches ImGui::PlotLines' values_offset.
+		struct FrameTimeRing
+		{
+			const float* values = nullptr;
+			size_t count = 0;
+			size_t oldest = 0;
+		};
+
+		const FrameStats& GetFrameStats() const { return stats; }
+		FrameTimeRing GetFrameTimes() const;
+		// Frame times of the window counted into kHistogramBuckets buckets.
+		const std::vector<float>& GetFrameTimeHistogram() const { return histogram; }
+
+		// Game-defined values shown next to the engine's own (enemies alive, pathfinding ms, ...).
+		void SetCounter(const std::string& name, double value);
+		const std::vector<std::pair<std::string, double>>& GetCounters() const { return counters; }
+
+	private:
+		static size_t BucketOf(float milliseconds);
+		void UpdatePercentiles();
+
+		Engine* engine;
+		FrameStats stats;
+		FrameStats current;		// being filled by AddTick until EndFrame
+
+		std::chrono::steady_clock::time_point lastFrameEnd;
+		bool started = false;
+
+		std::vector<float> frameTimes;	// ring buffer
+		size_t nextFrame = 0;
+		size_t frameCount = 0;
+		std::vector<float> histogram;
+		std::vector<float> sortScratch;
+
+		std::vector<std::pair<std::string, double>> counters;
+	};
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <Types.h>
+
+namespace willengine
+{
+	// Axis-aligned box in world units.
+	struct AABB
+	{
+		vec2 min;
+		vec2 max;
+
+		AABB() = default;
+		AABB(const vec2& min, const vec2& max) : min(min), max(max) {}
+
+		// A BoxCollider's dimensionSizes are half extents.
+		static AABB FromCenter(const vec2& center, const vec2& halfExtents) { return AABB(center - halfExtents, center + halfExtents); }
+
+		bool Overlaps(const AABB& other) const
+		{
+			return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y && other.min.y <= max.y;
+		}
+		bool Contains(const vec2& point) const
+		{
+			return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y;
+		}
+		bool Contains(const AABB& other) const
+		{
+			return other.min.x >= min.x && other.max.x <= max.x && other.min.y >= min.y && other.max.y <= max.y;
+		}
+		AABB Union(const AABB& other) const { return AABB(glm::min(min, other.min), glm::max(max, other.max)); }
+		float Perimeter() const { return 2.0f * ((max.x - min.x) + (max.y - min.y)); }
+	};
+}
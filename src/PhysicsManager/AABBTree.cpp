@@ -0,0 +1,238 @@
+#include "AABBTree.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace willengine
+{
+	int32_t AABBTree::AllocateNode()
+	{
+		if (freeList == kNull) {
+			nodes.emplace_back();
+			nodes.back().height = 0;
+			return int32_t(nodes.size() - 1);
+		}
+		const int32_t node = freeList;
+		freeList = nodes[node].parent;
+		nodes[node] = Node();
+		nodes[node].height = 0;
+		return node;
+	}
+
+	void AABBTree::FreeNode(int32_t node)
+	{
+		nodes[node].parent = freeList;
+		nodes[node].height = -1;
+		freeList = node;
+	}
+
+	void AABBTree::Clear()
+	{
+		nodes.clear();
+		root = kNull;
+		freeList = kNull;
+	}
+
+	int32_t AABBTree::CreateProxy(const AABB& box, entityID entity)
+	{
+		const int32_t proxy = AllocateNode();
+		nodes[proxy].box = box;
+		nodes[proxy].fat = AABB(box.min - vec2(margin), box.max + vec2(margin));
+		nodes[proxy].entity = entity;
+		InsertLeaf(proxy);
+		return proxy;
+	}
+
+	void AABBTree::DestroyProxy(int32_t proxy)
+	{
+		RemoveLeaf(proxy);
+		FreeNode(proxy);
+	}
+
+	bool AABBTree::MoveProxy(int32_t proxy, const AABB& box)
+	{
+		nodes[proxy].box = box;
+		if (nodes[proxy].fat.Contains(box)) return false;
+
+		RemoveLeaf(proxy);
+		nodes[proxy].fat = AABB(box.min - vec2(margin), box.max + vec2(margin));
+		InsertLeaf(proxy);
+		return true;
+	}
+
+	void AABBTree::InsertLeaf(int32_t leaf)
+	{
+		if (root == kNull) {
+			root = leaf;
+			nodes[root].parent = kNull;
+			return;
+		}
+
+		// Walk down to the sibling that makes the tree's total perimeter grow the least.
+		const AABB leafBox = nodes[leaf].fat;
+		int32_t index = root;
+		while (!nodes[index].IsLeaf()) {
+			const Node& node = nodes[index];
+			const float area = node.fat.Perimeter();
+			const float combinedArea = node.fat.Union(leafBox).Perimeter();
+
+			// Cost of making a new parent for this node and the leaf, and the minimum cost of
+			// pushing the leaf further down, which grows this node's box regardless.
+			const float cost = 2.0f * combinedArea;
+			const float inheritanceCost = 2.0f * (combinedArea - area);
+
+			auto descendCost = [&](int32_t child) {
+				const float grown = nodes[child].fat.Union(leafBox).Perimeter();
+				return (nodes[child].IsLeaf() ? grown : grown - nodes[child].fat.Perimeter()) + inheritanceCost;
+			};
+			const float leftCost = descendCost(node.left);
+			const float rightCost = descendCost(node.right);
+
+			if (cost < leftCost && cost < rightCost) break;
+			index = leftCost < rightCost ? node.left : node.right;
+		}
+		const int32_t sibling = index;
+
+		// New parent for the sibling and the leaf. AllocateNode may grow `nodes`, so no references across it.
+		const int32_t oldParent = nodes[sibling].parent;
+		const int32_t newParent = AllocateNode();
+		nodes[newParent].parent = oldParent;
+		nodes[newParent].fat = leafBox.Union(nodes[sibling].fat);
+		nodes[newParent].height = nodes[sibling].height + 1;
+		nodes[newParent].left = sibling;
+		nodes[newParent].right = leaf;
+		nodes[sibling].parent = newParent;
+		nodes[leaf].parent = newParent;
+
+		if (oldParent == kNull) {
+			root = newParent;
+		}
+		else if (nodes[oldParent].left == sibling) {
+			nodes[oldParent].left = newParent;
+		}
+		else {
+			nodes[oldParent].right = newParent;
+		}
+
+		// Refit and rebalance on the way up.
+		for (index = nodes[leaf].parent; index != kNull; index = nodes[index].parent) {
+			index = Balance(index);
+			Node& node = nodes[index];
+			node.height = 1 + std::max(nodes[node.left].height, nodes[node.right].height);
+			node.fat = nodes[node.left].fat.Union(nodes[node.right].fat);
+		}
+	}
+
+	void AABBTree::RemoveLeaf(int32_t leaf)
+	{
+		if (leaf == root) {
+			root = kNull;
+			return;
+		}
+
+		const int32_t parent = nodes[leaf].parent;
+		const int32_t grandParent = nodes[parent].parent;
+		const int32_t sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+		if (grandParent == kNull) {
+			root = sibling;
+			nodes[sibling].parent = kNull;
+			FreeNode(parent);
+			return;
+		}
+
+		// The sibling takes the parent's place.
+		if (nodes[grandParent].left == parent) {
+			nodes[grandParent].left = sibling;
+		}
+		else {
+			nodes[grandParent].right = sibling;
+		}
+		nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		for (int32_t index = grandParent; index != kNull; index = nodes[index].parent) {
+			index = Balance(index);
+			Node& node = nodes[index];
+			node.height = 1 + std::max(nodes[node.left].height, nodes[node.right].height);
+			node.fat = nodes[node.left].fat.Union(nodes[node.right].fat);
+		}
+	}
+
+	// If one child of `a` is more than one level taller than the other, rotate it up into a's place.
+	// Returns the node now at a's position.
+	int32_t AABBTree::Balance(int32_t a)
+	{
+		if (nodes[a].IsLeaf() || nodes[a].height < 2) return a;
+
+		const int32_t b = nodes[a].left;
+		const int32_t c = nodes[a].right;
+		const int32_t balance = nodes[c].height - nodes[b].height;
+		if (balance >= -1 && balance <= 1) return a;
+
+		// `up` is the taller child, `other` a's remaining child. `up` keeps its taller child
+		// and hands the shorter one to `a`.
+		const bool rotateRight = balance > 1;
+		const int32_t up = rotateRight ? c : b;
+		const int32_t other = rotateRight ? b : c;
+		const int32_t upLeft = nodes[up].left;
+		const int32_t upRight = nodes[up].right;
+		const bool keepLeft = nodes[upLeft].height > nodes[upRight].height;
+		const int32_t kept = keepLeft ? upLeft : upRight;
+		const int32_t given = keepLeft ? upRight : upLeft;
+
+		// `up` replaces `a` under a's parent.
+		nodes[up].parent = nodes[a].parent;
+		nodes[a].parent = up;
+		if (nodes[up].parent == kNull) {
+			root = up;
+		}
+		else if (nodes[nodes[up].parent].left == a) {
+			nodes[nodes[up].parent].left = up;
+		}
+		else {
+			nodes[nodes[up].parent].right = up;
+		}
+
+		nodes[up].left = a;
+		nodes[up].right = kept;
+		if (rotateRight) {
+			nodes[a].right = given;
+		}
+		else {
+			nodes[a].left = given;
+		}
+		nodes[given].parent = a;
+
+		nodes[a].fat = nodes[other].fat.Union(nodes[given].fat);
+		nodes[a].height = 1 + std::max(nodes[other].height, nodes[given].height);
+		nodes[up].fat = nodes[a].fat.Union(nodes[kept].fat);
+		nodes[up].height = 1 + std::max(nodes[a].height, nodes[kept].height);
+		return up;
+	}
+
+	float AABBTree::RayDistance(const AABB& box, const vec2& origin, const vec2& inverseDirection, float maxDistance)
+	{
+		float enter = 0.0f;
+		float exit = maxDistance;
+		for (int axis = 0; axis < 2; ++axis) {
+			const float o = axis == 0 ? origin.x : origin.y;
+			const float inverse = axis == 0 ? inverseDirection.x : inverseDirection.y;
+			const float lo = axis == 0 ? box.min.x : box.min.y;
+			const float hi = axis == 0 ? box.max.x : box.max.y;
+
+			if (std::isinf(inverse)) {
+				// Parallel to this axis: inside the slab or never.
+				if (o < lo || o > hi) return -1.0f;
+				continue;
+			}
+			float t0 = (lo - o) * inverse;
+			float t1 = (hi - o) * inverse;
+			if (t0 > t1) std::swap(t0, t1);
+			enter = std::max(enter, t0);
+			exit = std::min(exit, t1);
+			if (enter > exit) return -1.0f;
+		}
+		return enter;
+	}
+}
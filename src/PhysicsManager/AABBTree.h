@@ -0,0 +1,140 @@
+#pragma once
+#include "AABB.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace willengine
+{
+	/*
+		Dynamic bounding volume tree over collider boxes, for spatial queries (point, box, ray).
+		Leaves store a "fat" box, the collider grown by a margin, so a collider that moves a little
+		stays in its leaf and only one that leaves its fat box is reinserted. Inserts pick the
+		sibling by surface area cost and rotations keep the tree balanced, so queries stay O(log n).
+		Queries don't modify the tree and may run on several threads at once.
+	*/
+	class AABBTree
+	{
+	public:
+		static constexpr int32_t kNull = -1;
+
+		explicit AABBTree(float margin = 4.0f) : margin(margin) {}
+
+		int32_t CreateProxy(const AABB& box, entityID entity);
+		void DestroyProxy(int32_t proxy);
+		// Updates the collider's box. Returns true if it left its fat box and was reinserted.
+		bool MoveProxy(int32_t proxy, const AABB& box);
+		void Clear();
+
+		entityID GetEntity(int32_t proxy) const { return nodes[proxy].entity; }
+		const AABB& GetBox(int32_t proxy) const { return nodes[proxy].box; }
+		int32_t GetHeight() const { return root == kNull ? 0 : nodes[root].height; }
+
+		// Calls callback(proxy) for every collider whose box overlaps `box`. Return false to stop.
+		template<typename F>
+		void Query(const AABB& box, F&& callback) const;
+
+		// Calls callback(proxy, distance) for colliders hit by the ray within maxDistance, where distance
+		// is where the ray enters the box. The callback returns the new maxDistance: the distance itself
+		// to find the closest hit, maxDistance to find all of them, 0 to stop.
+		template<typename F>
+		void Raycast(const vec2& origin, const vec2& direction, float maxDistance, F&& callback) const;
+
+		// Where a ray enters a box (0 if it starts inside), or a negative number if it misses.
+		static float RayDistance(const AABB& box, const vec2& origin, const vec2& inverseDirection, float maxDistance);
+
+	private:
+		struct Node
+		{
+			AABB fat;			// leaves: box plus margin; inner nodes: union of the children
+			AABB box;			// leaves: the collider's box
+			entityID entity = 0;
+			int32_t parent = kNull;	// next free node while on the free list
+			int32_t left = kNull;
+			int32_t right = kNull;
+			int32_t height = -1;	// leaves 0, free nodes -1
+
+			bool IsLeaf() const { return left == kNull; }
+		};
+
+		// Traversal stack without heap allocation for any realistically balanced tree.
+		class Stack
+		{
+		public:
+			void Push(int32_t node)
+			{
+				if (count < fixed.size()) fixed[count] = node;
+				else overflow.push_back(node);
+				count++;
+			}
+			int32_t Pop()
+			{
+				count--;
+				if (count < fixed.size()) return fixed[count];
+				const int32_t node = overflow.back();
+				overflow.pop_back();
+				return node;
+			}
+			bool Empty() const { return count == 0; }
+		private:
+			std::array<int32_t, 64> fixed;
+			std::vector<int32_t> overflow;
+			size_t count = 0;
+		};
+
+		int32_t AllocateNode();
+		void FreeNode(int32_t node);
+		void InsertLeaf(int32_t leaf);
+		void RemoveLeaf(int32_t leaf);
+		int32_t Balance(int32_t node);
+
+		std::vector<Node> nodes;
+		int32_t root = kNull;
+		int32_t freeList = kNull;
+		float margin;
+	};
+
+	template<typename F>
+	void AABBTree::Query(const AABB& box, F&& callback) const
+	{
+		Stack stack;
+		if (root != kNull) stack.Push(root);
+		while (!stack.Empty()) {
+			const Node& node = nodes[stack.Pop()];
+			if (!node.fat.Overlaps(box)) continue;
+
+			if (node.IsLeaf()) {
+				if (node.box.Overlaps(box) && !callback(int32_t(&node - nodes.data()))) return;
+			}
+			else {
+				stack.Push(node.left);
+				stack.Push(node.right);
+			}
+		}
+	}
+
+	template<typename F>
+	void AABBTree::Raycast(const vec2& origin, const vec2& direction, float maxDistance, F&& callback) const
+	{
+		// Division by zero gives infinities, which the slab test handles.
+		const vec2 inverseDirection(1.0f / direction.x, 1.0f / direction.y);
+
+		Stack stack;
+		if (root != kNull) stack.Push(root);
+		while (!stack.Empty()) {
+			const Node& node = nodes[stack.Pop()];
+			if (RayDistance(node.fat, origin, inverseDirection, maxDistance) < 0.0f) continue;
+
+			if (node.IsLeaf()) {
+				const float distance = RayDistance(node.box, origin, inverseDirection, maxDistance);
+				if (distance < 0.0f) continue;
+				maxDistance = callback(int32_t(&node - nodes.data()), distance);
+				if (maxDistance <= 0.0f) return;
+			}
+			else {
+				stack.Push(node.left);
+				stack.Push(node.right);
+			}
+		}
+	}
+}
@@ -0,0 +1,167 @@
+#include "IntegrationKernels.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WILLENGINE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC compiles any intrinsic without flags.
+#define WILLENGINE_TARGET(isa)
+#else
+// Only these functions are compiled for the extension, the rest of the engine stays on the baseline.
+#define WILLENGINE_TARGET(isa) __attribute__((target(isa)))
+#endif
+#else
+#define WILLENGINE_X86 0
+#endif
+
+namespace willengine
+{
+	namespace
+	{
+		// One axis of one body. The reference the SIMD kernels have to match, and their tail loop.
+		inline void IntegrateAxis(float& position, float& velocity, float halfExtent, float dt, float worldHalf)
+		{
+			const float hi = worldHalf - halfExtent;
+			const float lo = halfExtent - worldHalf;
+			const float moved = position + velocity * dt;
+			const float clampedHi = std::min(moved, hi);
+			const float clamped = std::max(clampedHi, lo);
+			const bool hitEdge = (moved > hi) | (clampedHi < lo);
+			position = clamped;
+			velocity = hitEdge ? 0.0f : velocity;
+		}
+
+		inline void IntegrateRange(BodyArrays& bodies, size_t begin, size_t end, float dt, float halfWidth, float halfHeight)
+		{
+			float* px = bodies.px.data();
+			float* py = bodies.py.data();
+			float* vx = bodies.vx.data();
+			float* vy = bodies.vy.data();
+			const float* hx = bodies.hx.data();
+			const float* hy = bodies.hy.data();
+			for (size_t i = begin; i < end; ++i) {
+				IntegrateAxis(px[i], vx[i], hx[i], dt, halfWidth);
+				IntegrateAxis(py[i], vy[i], hy[i], dt, halfHeight);
+			}
+		}
+
+#if WILLENGINE_X86
+		// minps/maxps return their second operand when the two are equal (+0 and -0) or one is NaN,
+		// std::min(a, b)/std::max(a, b) return a. Hence the swapped operands: min(hi, moved) is std::min(moved, hi).
+		WILLENGINE_TARGET("sse2")
+		inline void IntegrateAxisSSE2(float* position, float* velocity, const float* halfExtent, __m128 dt, __m128 worldHalf)
+		{
+			const __m128 half = _mm_loadu_ps(halfExtent);
+			const __m128 hi = _mm_sub_ps(worldHalf, half);
+			const __m128 lo = _mm_sub_ps(half, worldHalf);
+			const __m128 v = _mm_loadu_ps(velocity);
+			const __m128 moved = _mm_add_ps(_mm_loadu_ps(position), _mm_mul_ps(v, dt));
+			const __m128 clampedHi = _mm_min_ps(hi, moved);
+			const __m128 clamped = _mm_max_ps(lo, clampedHi);
+			const __m128 hitEdge = _mm_or_ps(_mm_cmpgt_ps(moved, hi), _mm_cmplt_ps(clampedHi, lo));
+			_mm_storeu_ps(position, clamped);
+			_mm_storeu_ps(velocity, _mm_andnot_ps(hitEdge, v));
+		}
+
+		WILLENGINE_TARGET("avx")
+		inline void IntegrateAxisAVX(float* position, float* velocity, const float* halfExtent, __m256 dt, __m256 worldHalf)
+		{
+			const __m256 half = _mm256_loadu_ps(halfExtent);
+			const __m256 hi = _mm256_sub_ps(worldHalf, half);
+			const __m256 lo = _mm256_sub_ps(half, worldHalf);
+			const __m256 v = _mm256_loadu_ps(velocity);
+			const __m256 moved = _mm256_add_ps(_mm256_loadu_ps(position), _mm256_mul_ps(v, dt));
+			const __m256 clampedHi = _mm256_min_ps(hi, moved);
+			const __m256 clamped = _mm256_max_ps(lo, clampedHi);
+			const __m256 hitEdge = _mm256_or_ps(_mm256_cmp_ps(moved, hi, _CMP_GT_OQ), _mm256_cmp_ps(clampedHi, lo, _CMP_LT_OQ));
+			_mm256_storeu_ps(position, clamped);
+			_mm256_storeu_ps(velocity, _mm256_andnot_ps(hitEdge, v));
+		}
+#endif
+	}
+
+	void IntegrateScalar(BodyArrays& bodies, float dt, float halfWidth, float halfHeight)
+	{
+		IntegrateRange(bodies, 0, bodies.Size(), dt, halfWidth, halfHeight);
+	}
+
+#if WILLENGINE_X86
+	WILLENGINE_TARGET("sse2")
+	void IntegrateSSE2(BodyArrays& bodies, float dt, float halfWidth, float halfHeight)
+	{
+		const size_t count = bodies.Size();
+		const size_t packed = count & ~size_t(3);
+		const __m128 step = _mm_set1_ps(dt);
+		const __m128 width = _mm_set1_ps(halfWidth);
+		const __m128 height = _mm_set1_ps(halfHeight);
+		for (size_t i = 0; i < packed; i += 4) {
+			IntegrateAxisSSE2(&bodies.px[i], &bodies.vx[i], &bodies.hx[i], step, width);
+			IntegrateAxisSSE2(&bodies.py[i], &bodies.vy[i], &bodies.hy[i], step, height);
+		}
+		IntegrateRange(bodies, packed, count, dt, halfWidth, halfHeight);
+	}
+
+	WILLENGINE_TARGET("avx")
+	void IntegrateAVX(BodyArrays& bodies, float dt, float halfWidth, float halfHeight)
+	{
+		const size_t count = bodies.Size();
+		const size_t packed = count & ~size_t(7);
+		const __m256 step = _mm256_set1_ps(dt);
+		const __m256 width = _mm256_set1_ps(halfWidth);
+		const __m256 height = _mm256_set1_ps(halfHeight);
+		for (size_t i = 0; i < packed; i += 8) {
+			IntegrateAxisAVX(&bodies.px[i], &bodies.vx[i], &bodies.hx[i], step, width);
+			IntegrateAxisAVX(&bodies.py[i], &bodies.vy[i], &bodies.hy[i], step, height);
+		}
+		_mm256_zeroupper();
+		IntegrateRange(bodies, packed, count, dt, halfWidth, halfHeight);
+	}
+#else
+	// No x86 SIMD here. The scalar loop is written so the compiler can vectorize it for the target.
+	void IntegrateSSE2(BodyArrays& bodies, float dt, float halfWidth, float halfHeight) { IntegrateScalar(bodies, dt, halfWidth, halfHeight); }
+	void IntegrateAVX(BodyArrays& bodies, float dt, float halfWidth, float halfHeight) { IntegrateScalar(bodies, dt, halfWidth, halfHeight); }
+#endif
+
+	SimdLevel DetectSimdLevel()
+	{
+#if WILLENGINE_X86
+#if defined(_MSC_VER)
+		// AVX needs the CPU flag and the OS saving the YMM registers (OSXSAVE + XCR0 bits 1 and 2).
+		int info[4];
+		__cpuid(info, 1);
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (avx && osxsave && (_xgetbv(0) & 6) == 6) return SimdLevel::AVX;
+		if (info[3] & (1 << 26)) return SimdLevel::SSE2;
+		return SimdLevel::Scalar;
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx")) return SimdLevel::AVX;
+		if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+		return SimdLevel::Scalar;
+#endif
+#else
+		return SimdLevel::Scalar;
+#endif
+	}
+
+	IntegrateKernel GetIntegrateKernel(SimdLevel level)
+	{
+		switch (std::min(level, DetectSimdLevel())) {
+		case SimdLevel::AVX: return &IntegrateAVX;
+		case SimdLevel::SSE2: return &IntegrateSSE2;
+		default: return &IntegrateScalar;
+		}
+	}
+
+	const char* SimdLevelName(SimdLevel level)
+	{
+		switch (level) {
+		case SimdLevel::AVX: return "AVX";
+		case SimdLevel::SSE2: return "SSE2";
+		default: return "scalar";
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <Types.h>
+#include <vector>
+
+namespace willengine
+{
+	// Bodies packed one array per field, so the integration kernel can work on several at once.
+	struct BodyArrays
+	{
+		std::vector<float> px, py;	// position
+		std::vector<float> vx, vy;	// velocity
+		std::vector<float> hx, hy;	// collider half extents
+
+		size_t Size() const { return px.size(); }
+		void Clear()
+		{
+			px.clear(); py.clear();
+			vx.clear(); vy.clear();
+			hx.clear(); hy.clear();
+		}
+		void Push(const vec2& position, const vec2& velocity, const vec2& halfExtents)
+		{
+			px.push_back(position.x); py.push_back(position.y);
+			vx.push_back(velocity.x); vy.push_back(velocity.y);
+			hx.push_back(halfExtents.x); hy.push_back(halfExtents.y);
+		}
+	};
+
+	enum class SimdLevel { Scalar, SSE2, AVX };
+
+	/*
+		position += velocity * dt, then keep the collider inside [-halfWidth, halfWidth] x [-halfHeight, halfHeight]:
+		a body pushed back in from an edge loses its velocity on that axis. Branchless min/max, so
+		every variant gives the same results as the scalar one.
+	*/
+	typedef void (*IntegrateKernel)(BodyArrays& bodies, float dt, float halfWidth, float halfHeight);
+
+	void IntegrateScalar(BodyArrays& bodies, float dt, float halfWidth, float halfHeight);
+	void IntegrateSSE2(BodyArrays& bodies, float dt, float halfWidth, float halfHeight);
+	void IntegrateAVX(BodyArrays& bodies, float dt, float halfWidth, float halfHeight);
+
+	// What this CPU (and OS) supports, checked at runtime.
+	SimdLevel DetectSimdLevel();
+	// The kernel for `level`, or the best supported one below it.
+	IntegrateKernel GetIntegrateKernel(SimdLevel level);
+	const char* SimdLevelName(SimdLevel level);
+}
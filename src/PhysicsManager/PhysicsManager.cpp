@@ -1,5 +1,9 @@
 #include "PhysicsManager.h"
 #include "../Engine.h"
+#include <spdlog/spdlog.h>
+#include "../Tracing/Trace.h"
+#include <algorithm>
+#include <cmath>
 namespace willengine
 {
 	PhysicsManager::PhysicsManager(Engine* engine)
@@ -11,53 +15,242 @@ namespace willengine
     {
         worldHalfHeight = config.worldHalfHeight;
         worldHalfWidth = config.worldHalfWidth;
+        broadPhase.SetCellSize(config.collision_cell_size);
+        maxSubsteps = std::max(config.physics_max_substeps, 1);
+
+        // Deterministic runs always take the scalar kernel, so the result can't depend on which CPU ran it.
+        const SimdLevel simd = config.physics_simd && !config.deterministic ? DetectSimdLevel() : SimdLevel::Scalar;
+        integrate = GetIntegrateKernel(simd);
+        spdlog::info("Physics integration kernel: {}", SimdLevelName(simd));
     }
-    void PhysicsManager::Update()
+    void PhysicsManager::Update(float dt)
     {
+        WILLENGINE_TRACE_ZONE("Physics::Update");
+        // Gather the bodies into packed arrays, integrate them all in one kernel call, write them back.
+        bodies.Clear();
+        bodyEntities.clear();
+        bodyRigidbodies.clear();
+        bodyTransforms.clear();
+        fastMovers.clear();
+        engine->ecs.ForEachComponent<Rigidbody>([&](entityID entity, Rigidbody& rb)
+            {
+                BoxCollider* collider = engine->ecs.TryGet<BoxCollider>(entity);
+                Transform* transform = engine->ecs.TryGet<Transform>(entity);
+                if (collider == nullptr || transform == nullptr) return;
+
+                // Moving more than its own size this tick: it could pass through a collider between two
+                // ticks, so collision detection also looks at the points in between.
+                if (maxSubsteps > 1) {
+                    const vec2 size = collider->dimensionSizes * 2.0f;
+                    const float travel = std::max(std::abs(rb.velocity.x) * dt / std::max(size.x, 0.001f), std::abs(rb.velocity.y) * dt / std::max(size.y, 0.001f));
+                    if (travel > 1.0f) {
+                        const int substeps = std::min(int(std::ceil(travel)), maxSubsteps);
+                        fastMovers.push_back(FastMover{ bodies.Size(), rb.position, substeps });
+                    }
+                }
+
+                bodies.Push(rb.position, rb.velocity, collider->dimensionSizes);
+                bodyEntities.push_back(entity);
+                bodyRigidbodies.push_back(&rb);
+                bodyTransforms.push_back(transform);
+            });
 
+        {
+            WILLENGINE_TRACE_ZONE("Physics::Integrate");
+            integrate(bodies, dt, worldHalfWidth, worldHalfHeight);
+        }
 
+        for (size_t i = 0; i < bodyRigidbodies.size(); ++i) {
+            Rigidbody& rb = *bodyRigidbodies[i];
+            rb.position = vec2(bodies.px[i], bodies.py[i]);
+            rb.velocity = vec2(bodies.vx[i], bodies.vy[i]);
+            *bodyTransforms[i] = rb.position;
+        }
 
-        engine->ecs.ForEach<Rigidbody, BoxCollider, Transform>([&](entityID entity)
+        DetectCollisions();
+    }
+
+    void PhysicsManager::DetectCollisions()
+    {
+        WILLENGINE_TRACE_ZONE("Physics::DetectCollisions");
+        proxyEntities.clear();
+        proxyColliders.clear();
+        proxyBoxes.clear();
+        previousContacts.swap(contacts);
+        contacts.clear();
+        broadPhase.Clear();
+        tick++;
+
+        engine->ecs.ForEachComponent<BoxCollider>([&](entityID entity, BoxCollider& collider)
             {
-                Rigidbody& rb = engine->ecs.Get<Rigidbody>(entity);
-                Transform& transform = engine->ecs.Get<Transform>(entity);
-                BoxCollider& collider = engine->ecs.Get<BoxCollider>(entity);
+                collider.isCollided = false;
+                Transform* transform = engine->ecs.TryGet<Transform>(entity);
+                if (transform == nullptr) return;
 
-                rb.position.x += rb.velocity.x;
-                rb.position.y += rb.velocity.y;
+                const AABB box = AABB::FromCenter(*transform, collider.dimensionSizes);
+                broadPhase.Insert(box);
+                proxyEntities.push_back(entity);
+                proxyColliders.push_back(&collider);
+                proxyBoxes.push_back(box);
+                UpdateTreeProxy(entity, box);
+            });
 
-                transform.x = rb.position.x;
-                transform.y = rb.position.y;
+        // Fast movers: their in-between boxes take part in the broad and narrow phase too (not in the query tree).
+        for (const FastMover& mover : fastMovers) {
+            const vec2 end(bodies.px[mover.body], bodies.py[mover.body]);
+            const vec2 halfExtents(bodies.hx[mover.body], bodies.hy[mover.body]);
+            for (int step = 1; step < mover.substeps; ++step) {
+                const vec2 position = mover.start + (end - mover.start) * (float(step) / float(mover.substeps));
+                const AABB box = AABB::FromCenter(position, halfExtents);
+                broadPhase.Insert(box);
+                proxyEntities.push_back(bodyEntities[mover.body]);
+                proxyColliders.push_back(engine->ecs.TryGet<BoxCollider>(bodyEntities[mover.body]));
+                proxyBoxes.push_back(box);
+            }
+        }
 
-                float halfSpriteWidth = collider.dimensionSizes.x;  // scale 20 = half-width 20
-                float halfSpriteHeight = collider.dimensionSizes.y;
+        // Colliders that weren't seen this tick are gone.
+        staleProxies.clear();
+        for (const auto& [entity, proxy] : treeProxies) {
+            if (proxy.seenTick != tick) staleProxies.push_back(entity);
+        }
+        // Removal order shapes the tree (and so query result order): keep it independent of hash map order.
+        std::sort(staleProxies.begin(), staleProxies.end());
+        for (entityID entity : staleProxies) {
+            colliderTree.DestroyProxy(treeProxies[entity].proxy);
+            treeProxies.erase(entity);
+        }
 
-                // Right edge
-                if (transform.x + halfSpriteWidth > worldHalfWidth)
-                {
-                    transform.x = worldHalfWidth - halfSpriteWidth;
-                    rb.position.x = transform.x;
-                    rb.velocity.x = 0;
-                }
-                // Left edge
-                if (transform.x - halfSpriteWidth < -worldHalfWidth)
-                {
-                    transform.x = -worldHalfWidth + halfSpriteWidth;
-                    rb.position.x = transform.x;
-                    rb.velocity.x = 0;
-                }
-                if (transform.y + halfSpriteHeight > worldHalfHeight)
-                {
-                    transform.y = worldHalfHeight - halfSpriteHeight;
-                    rb.position.y = transform.y;
-                    rb.velocity.y = 0;
-                }
-                if (transform.y - halfSpriteHeight < -worldHalfHeight)
-                {
-                    transform.y = -worldHalfHeight + halfSpriteHeight;
-                    rb.position.y = transform.y;
-                    rb.velocity.y = 0;
-                }
+        broadPhase.FindPairs(candidatePairs);
+
+        // Narrow phase: exact AABB test on the candidates.
+        for (const auto& [first, second] : candidatePairs) {
+            if (proxyEntities[first] == proxyEntities[second]) continue;	// a fast mover's own substeps
+            const AABB& a = proxyBoxes[first];
+            const AABB& b = proxyBoxes[second];
+            if (!a.Overlaps(b)) continue;
+
+            const vec2 overlap = glm::min(a.max, b.max) - glm::max(a.min, b.min);
+            const vec2 delta = (b.min + b.max) - (a.min + a.max);
+            Contact contact;
+            contact.a = proxyEntities[first];
+            contact.b = proxyEntities[second];
+            if (overlap.x < overlap.y) {
+                contact.normal = vec2(delta.x < 0.0f ? -1.0f : 1.0f, 0.0f);
+                contact.depth = overlap.x;
+            }
+            else {
+                contact.normal = vec2(0.0f, delta.y < 0.0f ? -1.0f : 1.0f);
+                contact.depth = overlap.y;
+            }
+            if (contact.b < contact.a) {
+                std::swap(contact.a, contact.b);
+                contact.normal = -contact.normal;
+            }
+            contacts.push_back(contact);
+
+            proxyColliders[first]->isCollided = true;
+            proxyColliders[second]->isCollided = true;
+        }
+
+        // Sorted, so ClassifyContacts can merge against the previous step. A fast mover can touch
+        // the same collider at several substeps: keep the deepest contact.
+        std::sort(contacts.begin(), contacts.end(), [](const Contact& x, const Contact& y) {
+            if (x.a != y.a) return x.a < y.a;
+            if (x.b != y.b) return x.b < y.b;
+            return x.depth > y.depth;
+            });
+        if (!fastMovers.empty()) {
+            contacts.erase(std::unique(contacts.begin(), contacts.end(), [](const Contact& x, const Contact& y) {
+                return x.a == y.a && x.b == y.b;
+                }), contacts.end());
+        }
+
+        ClassifyContacts();
+    }
+
+    void PhysicsManager::ClassifyContacts()
+    {
+        // Both lists are sorted by (a, b): one merge pass, no lookups, no allocation once the buffers have grown.
+        std::vector<Contact>& begin = phaseContacts[int(ContactPhase::Begin)];
+        std::vector<Contact>& stay = phaseContacts[int(ContactPhase::Stay)];
+        std::vector<Contact>& end = phaseContacts[int(ContactPhase::End)];
+        begin.clear();
+        stay.clear();
+        end.clear();
+
+        size_t i = 0, j = 0;
+        while (i < contacts.size() || j < previousContacts.size()) {
+            if (j == previousContacts.size()) {
+                begin.push_back(contacts[i++]);
+                continue;
+            }
+            if (i == contacts.size()) {
+                end.push_back(previousContacts[j++]);
+                continue;
+            }
+            const Contact& now = contacts[i];
+            const Contact& before = previousContacts[j];
+            if (now.a == before.a && now.b == before.b) {
+                stay.push_back(now);
+                i++;
+                j++;
+            }
+            else if (now.a < before.a || (now.a == before.a && now.b < before.b)) {
+                begin.push_back(contacts[i++]);
+            }
+            else {
+                end.push_back(previousContacts[j++]);
+            }
+        }
+    }
+
+    const std::vector<Contact>& PhysicsManager::GetContacts(ContactPhase phase) const
+    {
+        return phaseContacts[int(phase)];
+    }
+
+    void PhysicsManager::UpdateTreeProxy(entityID entity, const AABB& box)
+    {
+        auto it = treeProxies.find(entity);
+        if (it == treeProxies.end()) {
+            treeProxies.emplace(entity, TreeProxy{ colliderTree.CreateProxy(box, entity), tick });
+            return;
+        }
+        colliderTree.MoveProxy(it->second.proxy, box);
+        it->second.seenTick = tick;
+    }
+
+    void PhysicsManager::QueryAABB(const AABB& box, std::vector<entityID>& out) const
+    {
+        colliderTree.Query(box, [&](int32_t proxy) {
+            out.push_back(colliderTree.GetEntity(proxy));
+            return true;
+            });
+    }
+
+    void PhysicsManager::QueryPoint(const vec2& point, std::vector<entityID>& out) const
+    {
+        QueryAABB(AABB(point, point), out);
+    }
+
+    bool PhysicsManager::Raycast(const vec2& origin, const vec2& direction, float maxDistance, RaycastHit& hit) const
+    {
+        const float length = glm::length(direction);
+        if (length <= 0.0f || maxDistance <= 0.0f) return false;
+        const vec2 unit = direction * (1.0f / length);
+
+        bool found = false;
+        colliderTree.Raycast(origin, unit, maxDistance, [&](int32_t proxy, float distance) {
+            // Clip the ray to this hit, so only closer colliders are visited from now on.
+            found = true;
+            hit.entity = colliderTree.GetEntity(proxy);
+            hit.distance = distance;
+            return distance;
             });
+        if (found) {
+            hit.point = origin + unit * hit.distance;
+        }
+        return found;
     }
-}
\ No newline at end of file
+}
@@ -1,8 +1,26 @@
 #pragma once
 #include "../Engine.h"
+#include "SpatialHash.h"
+#include "AABBTree.h"
+#include "IntegrationKernels.h"
+#include <unordered_map>
+#include <vector>
 namespace willengine
 {
 	class Engine;
+
+	// Two overlapping BoxColliders. `normal` points from a to b, along the axis of least penetration.
+	struct Contact
+	{
+		entityID a;
+		entityID b;
+		vec2 normal;
+		float depth;
+	};
+
+	// How a contact changed since the previous step.
+	enum class ContactPhase { Begin, Stay, End };
+
 	class PhysicsManager
 	{
 	public:
@@ -10,10 +28,72 @@ namespace willengine
 		~PhysicsManager() = default;
 
 		void Startup(Engine::Config& config);
-		void Update();
+		// One fixed step of `dt` seconds. Velocities are in world units per second.
+		void Update(float dt);
+
+		// Contacts found by the last Update, a < b in each, sorted by (a, b).
+		const std::vector<Contact>& GetContacts() const { return contacts; }
+		// The last Update's contacts split by phase: new this step, still touching, or separated
+		// (an End contact keeps its last normal and depth). Buffers are reused, read them before the next Update.
+		const std::vector<Contact>& GetContacts(ContactPhase phase) const;
+
+		// Spatial queries over BoxColliders, as of the last Update. Results are appended to `out`.
+		void QueryAABB(const AABB& box, std::vector<entityID>& out) const;
+		void QueryPoint(const vec2& point, std::vector<entityID>& out) const;
+
+		struct RaycastHit
+		{
+			entityID entity;
+			vec2 point;
+			float distance;
+		};
+		// Closest collider along the ray, within maxDistance world units.
+		bool Raycast(const vec2& origin, const vec2& direction, float maxDistance, RaycastHit& hit) const;
 	private:
+		void DetectCollisions();
+		void ClassifyContacts();
+		void UpdateTreeProxy(entityID entity, const AABB& box);
+
 		Engine* engine;
 		float worldHalfHeight;
 		float worldHalfWidth;
+
+		// Integration: Rigidbody + BoxCollider + Transform entities, packed for the SIMD kernel.
+		IntegrateKernel integrate = &IntegrateScalar;
+		BodyArrays bodies;
+		std::vector<entityID> bodyEntities;
+		std::vector<Rigidbody*> bodyRigidbodies;
+		std::vector<Transform*> bodyTransforms;
+
+		// Bodies that move more than their own size in one step, see Config::physics_max_substeps.
+		struct FastMover
+		{
+			size_t body;		// index into bodies
+			vec2 start;			// position before the step
+			int substeps;
+		};
+		std::vector<FastMover> fastMovers;
+		int maxSubsteps = 4;
+
+		// Collision detection. Kept between ticks so steady state doesn't allocate.
+		SpatialHash broadPhase;
+		std::vector<entityID> proxyEntities;		// broad phase id -> entity
+		std::vector<BoxCollider*> proxyColliders;
+		std::vector<AABB> proxyBoxes;
+		std::vector<std::pair<uint32_t, uint32_t>> candidatePairs;
+		std::vector<Contact> contacts;
+		std::vector<Contact> previousContacts;
+		std::vector<Contact> phaseContacts[3];	// indexed by ContactPhase
+
+		// Query index, updated incrementally: only colliders that left their fat box are reinserted.
+		struct TreeProxy
+		{
+			int32_t proxy;
+			uint32_t seenTick;
+		};
+		AABBTree colliderTree;
+		std::unordered_map<entityID, TreeProxy> treeProxies;
+		std::vector<entityID> staleProxies;
+		uint32_t tick = 0;
 	};
 }
@@ -0,0 +1,85 @@
+#include "SpatialHash.h"
+#include <algorithm>
+#include <cmath>
+
+namespace willengine
+{
+	void SpatialHash::SetCellSize(float size)
+	{
+		cellSize = std::max(size, 0.001f);
+		inverseCellSize = 1.0f / cellSize;
+	}
+
+	void SpatialHash::Clear()
+	{
+		boxes.clear();
+		entries.clear();
+	}
+
+	uint64_t SpatialHash::CellOf(const vec2& point) const
+	{
+		return CellKey(int32_t(std::floor(point.x * inverseCellSize)), int32_t(std::floor(point.y * inverseCellSize)));
+	}
+
+	uint32_t SpatialHash::Insert(const AABB& box)
+	{
+		const uint32_t id = uint32_t(boxes.size());
+		boxes.push_back(box);
+
+		const int32_t minX = int32_t(std::floor(box.min.x * inverseCellSize));
+		const int32_t minY = int32_t(std::floor(box.min.y * inverseCellSize));
+		const int32_t maxX = int32_t(std::floor(box.max.x * inverseCellSize));
+		const int32_t maxY = int32_t(std::floor(box.max.y * inverseCellSize));
+		for (int32_t y = minY; y <= maxY; ++y) {
+			for (int32_t x = minX; x <= maxX; ++x) {
+				entries.push_back(Entry{ CellKey(x, y), id });
+			}
+		}
+		return id;
+	}
+
+	void SpatialHash::FindPairs(std::vector<std::pair<uint32_t, uint32_t>>& pairs)
+	{
+		pairs.clear();
+		if (entries.empty()) return;
+
+		// Counting sort of the entries into a power-of-two bucket table, about two buckets per entry.
+		uint32_t bucketCount = 16;
+		while (bucketCount < entries.size() * 2) bucketCount <<= 1;
+		const uint32_t mask = bucketCount - 1;
+
+		bucketStarts.assign(bucketCount + 1, 0);
+		for (const Entry& entry : entries) {
+			bucketStarts[(Hash(entry.cell) & mask) + 1]++;
+		}
+		for (uint32_t i = 0; i < bucketCount; ++i) {
+			bucketStarts[i + 1] += bucketStarts[i];
+		}
+		sorted.resize(entries.size());
+		for (const Entry& entry : entries) {
+			// bucketStarts[b] is used as the write cursor and ends up at the start of bucket b + 1.
+			sorted[bucketStarts[Hash(entry.cell) & mask]++] = entry;
+		}
+
+		uint32_t begin = 0;
+		for (uint32_t bucket = 0; bucket < bucketCount; ++bucket) {
+			const uint32_t end = bucketStarts[bucket];
+			for (uint32_t i = begin; i < end; ++i) {
+				for (uint32_t j = i + 1; j < end; ++j) {
+					const Entry& a = sorted[i];
+					const Entry& b = sorted[j];
+					if (a.cell != b.cell || a.box == b.box) continue;	// another cell with the same hash
+
+					// Two boxes can share several cells. Only report the pair from the cell holding the
+					// corner of their overlap; for overlapping boxes both always touch that cell.
+					const AABB& boxA = boxes[a.box];
+					const AABB& boxB = boxes[b.box];
+					if (CellOf(glm::max(boxA.min, boxB.min)) != a.cell) continue;
+
+					pairs.emplace_back(std::min(a.box, b.box), std::max(a.box, b.box));
+				}
+			}
+			begin = end;
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "AABB.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace willengine
+{
+	/*
+		Uniform grid broad phase, rebuilt every tick. Boxes are bucketed by the cells they touch,
+		and only boxes sharing a cell become candidate pairs, so the cost follows the number of
+		boxes rather than the number of pairs. The cells live in a hash table, so the world needs
+		no bounds. Nothing is allocated once the buffers have grown to the scene's size.
+	*/
+	class SpatialHash
+	{
+	public:
+		void SetCellSize(float size);
+		float GetCellSize() const { return cellSize; }
+
+		void Clear();
+		// Returns the id FindPairs reports the box by: 0, 1, 2... in insertion order.
+		uint32_t Insert(const AABB& box);
+
+		// Every pair of boxes that share a cell, once each, with first < second.
+		// Candidates only: the boxes themselves may still not overlap.
+		void FindPairs(std::vector<std::pair<uint32_t, uint32_t>>& pairs);
+
+	private:
+		struct Entry
+		{
+			uint64_t cell;
+			uint32_t box;
+		};
+
+		uint64_t CellOf(const vec2& point) const;
+		static uint64_t CellKey(int32_t x, int32_t y) { return (uint64_t(uint32_t(x)) << 32) | uint32_t(y); }
+		static uint32_t Hash(uint64_t cell) { return uint32_t((cell * 0x9E3779B97F4A7C15ull) >> 32); }
+
+		float cellSize = 40.0f;
+		float inverseCellSize = 1.0f / 40.0f;
+		std::vector<AABB> boxes;
+		std::vector<Entry> entries;			// one per (box, cell it touches)
+		std::vector<Entry> sorted;			// entries grouped by bucket
+		std::vector<uint32_t> bucketStarts;
+	};
+}
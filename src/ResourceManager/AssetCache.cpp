@@ -0,0 +1,173 @@
+#include "AssetCache.h"
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+	constexpr uint32_t kCacheMagic = 0x57435348; // "WCSH"
+	constexpr uint32_t kCacheVersion = 2;
+
+	struct EntryHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t kind;
+		uint32_t format;
+		int64_t sourceWriteTime;
+		uint64_t sourceSize;
+		uint64_t sourceHash;
+		uint32_t width;
+		uint32_t height;
+		uint32_t channels;
+		uint32_t frames;
+		float sampleRate;
+		uint64_t payloadSize;
+	};
+}
+
+namespace willengine
+{
+	AssetCache::AssetCache(const std::filesystem::path& cacheDirectory)
+		:cacheDirectory(cacheDirectory)
+	{
+		std::error_code ec;
+		std::filesystem::create_directories(cacheDirectory, ec);
+		if (ec) {
+			spdlog::warn("Asset cache directory '{}' could not be created: {}", cacheDirectory.string(), ec.message());
+		}
+	}
+
+	uint64_t AssetCache::HashBytes(const void* data, size_t size, uint64_t seed)
+	{
+		// FNV-1a
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	bool AssetCache::HashFile(const std::filesystem::path& path, uint64_t& hash)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file) return false;
+
+		hash = 14695981039346656037ull;
+		char buffer[64 * 1024];
+		while (file) {
+			file.read(buffer, sizeof(buffer));
+			hash = HashBytes(buffer, static_cast<size_t>(file.gcount()), hash);
+		}
+		return true;
+	}
+
+	std::filesystem::path AssetCache::EntryPath(Kind kind, const std::filesystem::path& source) const
+	{
+		const std::string key = source.generic_string();
+		uint64_t hash = HashBytes(key.data(), key.size());
+		hash = HashBytes(&kind, sizeof(kind), hash);
+
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hash));
+		return cacheDirectory / name;
+	}
+
+	bool AssetCache::Load(Kind kind, const std::filesystem::path& source, CachedAsset& out)
+	{
+		std::error_code ec;
+		const int64_t writeTime = std::filesystem::last_write_time(source, ec).time_since_epoch().count();
+		if (ec) return false;
+		const uint64_t size = std::filesystem::file_size(source, ec);
+		if (ec) return false;
+
+		const std::filesystem::path entryPath = EntryPath(kind, source);
+		std::ifstream entry(entryPath, std::ios::binary);
+		if (!entry) return false;
+
+		EntryHeader header{};
+		if (!entry.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+		if (header.magic != kCacheMagic || header.version != kCacheVersion || header.kind != static_cast<uint32_t>(kind)) return false;
+		if (header.sourceSize != size) return false;
+
+		bool touched = false;
+		if (header.sourceWriteTime != writeTime) {
+			// The file was touched (checkout, save without edits...). Only a different content invalidates it.
+			uint64_t hash;
+			if (!HashFile(source, hash) || hash != header.sourceHash) return false;
+			touched = true;
+		}
+
+		// The payload must be exactly the rest of the file, and exactly what the header says it holds.
+		const std::streamoff payloadStart = entry.tellg();
+		entry.seekg(0, std::ios::end);
+		const std::streamoff fileEnd = entry.tellg();
+		entry.seekg(payloadStart);
+		if (payloadStart < 0 || fileEnd < payloadStart || header.payloadSize != uint64_t(fileEnd - payloadStart)) return false;
+		if (kind == Kind::TextureRGBA8) {
+			if (header.width == 0 || header.height == 0 || header.payloadSize != uint64_t(header.width) * header.height * 4) return false;
+		}
+		else if (kind == Kind::SoundPCM) {
+			if (header.channels == 0 || header.payloadSize != uint64_t(header.channels) * header.frames * sizeof(float)) return false;
+		}
+
+		out.width = header.width;
+		out.height = header.height;
+		out.channels = header.channels;
+		out.frames = header.frames;
+		out.sampleRate = header.sampleRate;
+		out.format = header.format;
+		out.payload.resize(header.payloadSize);
+		if (!entry.read(reinterpret_cast<char*>(out.payload.data()), static_cast<std::streamsize>(header.payloadSize))) return false;
+		entry.close();
+
+		// Refresh the stored time so the next run skips hashing again.
+		if (touched) Store(kind, source, out);
+		return true;
+	}
+
+	void AssetCache::Store(Kind kind, const std::filesystem::path& source, const CachedAsset& asset)
+	{
+		std::error_code ec;
+		EntryHeader header{};
+		header.magic = kCacheMagic;
+		header.version = kCacheVersion;
+		header.kind = static_cast<uint32_t>(kind);
+		header.format = asset.format;
+		header.sourceWriteTime = std::filesystem::last_write_time(source, ec).time_since_epoch().count();
+		if (ec) return;
+		header.sourceSize = std::filesystem::file_size(source, ec);
+		if (ec) return;
+		if (!HashFile(source, header.sourceHash)) return;
+		header.width = asset.width;
+		header.height = asset.height;
+		header.channels = asset.channels;
+		header.frames = asset.frames;
+		header.sampleRate = asset.sampleRate;
+		header.payloadSize = asset.payload.size();
+
+		// Write next to the final entry and rename it over, readers never see a partial file.
+		const std::filesystem::path entryPath = EntryPath(kind, source);
+		std::filesystem::path tempPath = entryPath;
+		tempPath += "." + std::to_string(std::random_device{}()) + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file) return;
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(asset.payload.data()), static_cast<std::streamsize>(asset.payload.size()));
+			if (!file) {
+				file.close();
+				std::filesystem::remove(tempPath, ec);
+				return;
+			}
+		}
+
+		std::filesystem::rename(tempPath, entryPath, ec);
+		if (ec) {
+			std::filesystem::remove(tempPath, ec);
+		}
+	}
+}
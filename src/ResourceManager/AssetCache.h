@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace willengine
+{
+	// Decoded payload of an asset plus the few numbers needed to use it again.
+	struct CachedAsset
+	{
+		uint32_t width = 0;			// textures
+		uint32_t height = 0;		// textures
+		uint32_t channels = 0;		// sounds
+		uint32_t frames = 0;		// sounds, samples per channel
+		float sampleRate = 0.0f;	// sounds
+		uint32_t format = 0;		// payload flavour, e.g. the Lua version bytecode was dumped with
+		std::vector<unsigned char> payload;
+	};
+
+	/*
+		On-disk cache of decoded assets (RGBA8 pixels, PCM samples, Lua bytecode).
+		Entries are keyed by the asset path and validated against the source file's
+		modification time and size; when only the time changed, a content hash decides.
+		Entries are written to a temporary file and renamed into place, so an editor and
+		a game sharing the same assets folder never read a half written entry.
+	*/
+	class AssetCache
+	{
+	public:
+		enum class Kind : uint32_t
+		{
+			TextureRGBA8 = 1,
+			SoundPCM = 2,
+			LuaBytecode = 3
+		};
+
+		AssetCache(const std::filesystem::path& cacheDirectory);
+
+		// Returns true and fills `out` if a valid entry exists for `source`. Entries whose payload doesn't match
+		// the file length or their own dimensions (truncated, corrupt) count as misses.
+		bool Load(Kind kind, const std::filesystem::path& source, CachedAsset& out);
+		void Store(Kind kind, const std::filesystem::path& source, const CachedAsset& asset);
+
+		static uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+	private:
+		std::filesystem::path EntryPath(Kind kind, const std::filesystem::path& source) const;
+		static bool HashFile(const std::filesystem::path& path, uint64_t& hash);
+
+		std::filesystem::path cacheDirectory;
+	};
+}
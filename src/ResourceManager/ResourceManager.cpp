@@ -2,6 +2,11 @@
 #include <string>
 #include "../Engine.h"
 #include "../SoundManager/SoundManager.h"
+#include "../FileWatcher/FileWatcher.h"
+#include "AssetCache.h"
+#include "../ScriptManager/LuaCompat.h"
+#include "../Tracing/Trace.h"
+#include <cstring>
 #include <spdlog/spdlog.h>
 #include <stb_image.h>
 #include <GraphicsManager/GraphicsManager.cpp>
@@ -13,32 +18,104 @@ namespace willengine
 	{
 	}
 
+	ResourceManager::~ResourceManager()
+	{
+		StopHotReload();
+	}
+
+	void ResourceManager::Startup(Engine::Config& config)
+	{
+		if (config.asset_cache) {
+			cache = std::make_unique<AssetCache>(rootPath / ".cache");
+		}
+	}
+
 	std::string ResourceManager::ResolvePath(const std::string& relativePath)
 	{
 		return (rootPath / relativePath).string();
 	}
 
+	bool ResourceManager::IsSoundExtension(const std::string& extension)
+	{
+		return extension == ".wav" || extension == ".ogg" || extension == ".mp3" || extension == ".flac";
+	}
+
 	void ResourceManager::SetRootPath(const std::string& rootPath)
 	{
 		this->rootPath = rootPath;
+		if (cache) {
+			cache = std::make_unique<AssetCache>(this->rootPath / ".cache");
+		}
 	}
 
-	bool ResourceManager::LoadSound(const std::string& name, const std::string& relativePath)
+	bool ResourceManager::LoadSound(const std::string& name, const std::string& relativePath, bool stream)
 	{
+		WILLENGINE_TRACE_ZONE("Resource::LoadSound");
 		const std::string resolvedPath = engine->resource->ResolvePath(relativePath);
-		if (!resolvedPath.empty())
+		std::error_code ec;
+		const uintmax_t fileSize = std::filesystem::file_size(resolvedPath, ec);
+		if (ec)
+		{
+			spdlog::error("Failed to load sound: {}", resolvedPath);
+			return false;
+		}
+
+		// Long tracks (music) are decoded from disk while playing instead of up front.
+		if (stream || fileSize >= kStreamingThresholdBytes)
 		{
-			engine->sound->nameToSoundMap[name].load(resolvedPath.c_str());
-			spdlog::info("sound: " + name + " has loaded");
+			auto wavStream = std::make_unique<SoLoud::WavStream>();
+			if (wavStream->load(resolvedPath.c_str()) != SoLoud::SO_NO_ERROR)
+			{
+				spdlog::error("Failed to load sound: {}", resolvedPath);
+				return false;
+			}
+			engine->sound->InstallSound(name, std::move(wavStream), true);
+			spdlog::info("sound: " + name + " has loaded (streamed)");
 			return true;
 		}
-		return false;
+
+		auto wav = std::make_unique<SoLoud::Wav>();
+
+		// Decoded samples from a previous run. SoLoud keeps them as planar floats, which is what we store.
+		CachedAsset pcm;
+		if (cache && cache->Load(AssetCache::Kind::SoundPCM, resolvedPath, pcm) && pcm.channels > 0)
+		{
+			const size_t sampleCount = pcm.payload.size() / sizeof(float);
+			float* samples = new float[sampleCount];
+			std::memcpy(samples, pcm.payload.data(), sampleCount * sizeof(float));
+			if (wav->loadRawWave(samples, (unsigned int)sampleCount, pcm.sampleRate, pcm.channels, false, true) == SoLoud::SO_NO_ERROR)
+			{
+				engine->sound->InstallSound(name, std::move(wav), false);
+				spdlog::info("sound: " + name + " has loaded (cached)");
+				return true;
+			}
+			delete[] samples;
+		}
+
+		if (wav->load(resolvedPath.c_str()) != SoLoud::SO_NO_ERROR)
+		{
+			spdlog::error("Failed to load sound: {}", resolvedPath);
+			return false;
+		}
+
+		if (cache)
+		{
+			pcm.channels = wav->mChannels;
+			pcm.frames = wav->mSampleCount;
+			pcm.sampleRate = wav->mBaseSamplerate;
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(wav->mData);
+			pcm.payload.assign(bytes, bytes + size_t(wav->mSampleCount) * wav->mChannels * sizeof(float));
+			cache->Store(AssetCache::Kind::SoundPCM, resolvedPath, pcm);
+		}
+
+		engine->sound->InstallSound(name, std::move(wav), false);
+		spdlog::info("sound: " + name + " has loaded");
+		return true;
 	}
 	bool ResourceManager::DeleteSound(const std::string& name)
 	{
-		if (engine->sound->nameToSoundMap.contains(name))
+		if (engine->sound->RemoveSound(name))
 		{
-			engine->sound->nameToSoundMap.erase(name);
 			return true;
 		}
 		spdlog::error("following sound isn't included in the sounds: " + name);
@@ -47,15 +124,35 @@ namespace willengine
 
 	bool ResourceManager::LoadTexture(const std::string& name, const std::string& relativePath)
 	{
+		WILLENGINE_TRACE_ZONE("Resource::LoadTexture");
 		std::string resolvedTexturePath = engine->resource->ResolvePath(relativePath);
 
-		int width, height, channels;
-		unsigned char* data = stbi_load(resolvedTexturePath.c_str(), &width, &height, &channels, 4);
-		if (data == nullptr)
+		// Nothing is drawn headless: just know the name, so sprites referring to it stay valid.
+		if (engine->graphics->IsHeadless()) {
+			engine->graphics->texturesMap[name];
+			return true;
+		}
+
+		// Decoded RGBA8 pixels, either from the asset cache or from stb_image.
+		CachedAsset pixels;
+		if (!cache || !cache->Load(AssetCache::Kind::TextureRGBA8, resolvedTexturePath, pixels))
 		{
-			spdlog::error("Failed to load texture: {}", resolvedTexturePath);
-			return false;
+			int width, height, channels;
+			unsigned char* data = stbi_load(resolvedTexturePath.c_str(), &width, &height, &channels, 4);
+			if (data == nullptr)
+			{
+				spdlog::error("Failed to load texture: {}", resolvedTexturePath);
+				return false;
+			}
+			pixels.width = (uint32_t)width;
+			pixels.height = (uint32_t)height;
+			pixels.payload.assign(data, data + size_t(width) * height * 4);
+			stbi_image_free(data);
+
+			if (cache) cache->Store(AssetCache::Kind::TextureRGBA8, resolvedTexturePath, pixels);
 		}
+		const int width = (int)pixels.width;
+		const int height = (int)pixels.height;
 
 		WGPUTexture tex = wgpuDeviceCreateTexture(engine->graphics->device, to_ptr(WGPUTextureDescriptor{
 			.label = WGPUStringView(name.c_str(), WGPU_STRLEN),
@@ -70,16 +167,16 @@ namespace willengine
 		wgpuQueueWriteTexture(
 			engine->graphics->queue,
 			to_ptr<WGPUTexelCopyTextureInfo>({ .texture = tex }),
-			data,
+			pixels.payload.data(),
 			width * height * 4,
 			to_ptr<WGPUTexelCopyBufferLayout>({ .bytesPerRow = (uint32_t)(width * 4), .rowsPerImage = (uint32_t)height }),
 			to_ptr(WGPUExtent3D{ (uint32_t)width, (uint32_t)height, 1 })
 		);
 
-		stbi_image_free(data);
-
-		// Store in map
+		// Store in map. When re-importing, release the previous GPU objects first.
 		willengine::GraphicsManager::ImageData& img = engine->graphics->texturesMap[name];
+		if (img.texture) wgpuTextureRelease(img.texture);
+		if (img.bindGroup) wgpuBindGroupRelease(img.bindGroup);
 		img.width = width;
 		img.height = height;
 		img.texture = tex;
@@ -91,9 +188,12 @@ namespace willengine
 	}
 	bool ResourceManager::DeleteTexture(const std::string& name)
 	{
-		if (engine->graphics->texturesMap.contains(name))
+		auto it = engine->graphics->texturesMap.find(name);
+		if (it != engine->graphics->texturesMap.end())
 		{
-			engine->graphics->texturesMap.erase(name);
+			if (it->second.texture) wgpuTextureRelease(it->second.texture);
+			if (it->second.bindGroup) wgpuBindGroupRelease(it->second.bindGroup);
+			engine->graphics->texturesMap.erase(it);
 			return true;
 		}
 		spdlog::error("following texture isn't included in the textures: " + name);
@@ -102,9 +202,15 @@ namespace willengine
 
 	bool ResourceManager::LoadScript(const std::string& name, const std::string& relativePath)
 	{
+		WILLENGINE_TRACE_ZONE("Resource::LoadScript");
 		std::string resolvedPath = engine->resource->ResolvePath(relativePath);
-		sol::load_result loadResult = engine->script->lua.load_file(resolvedPath);
+		const std::string* bytecode = GetLuaBytecode(resolvedPath);
+		if (!bytecode) {
+			spdlog::error("Failed to load script '{}'", name);
+			return false;
+		}
 
+		sol::load_result loadResult = engine->script->lua.load(*bytecode, "@" + resolvedPath, sol::load_mode::binary);
 		if (!loadResult.valid()) {
 			sol::error err = loadResult;
 			spdlog::error("Failed to load script '{}': {}", name, err.what());
@@ -118,6 +224,54 @@ namespace willengine
 		spdlog::info("Loaded script '{}'", name);
 		return true;
 	}
+
+	const std::string* ResourceManager::GetLuaBytecode(const std::string& resolvedPath)
+	{
+		std::error_code error;
+		const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(resolvedPath, error);
+		const uintmax_t size = error ? 0 : std::filesystem::file_size(resolvedPath, error);
+		if (error) {
+			spdlog::error("Can't read Lua file '{}': {}", resolvedPath, error.message());
+			return nullptr;
+		}
+
+		// Still the version we compiled? One stat instead of a parse.
+		auto it = compiledLua.find(resolvedPath);
+		if (it != compiledLua.end() && it->second.writeTime == writeTime && it->second.size == size) {
+			return &it->second.bytecode;
+		}
+
+		CompiledLua compiled{ writeTime, size };
+
+		// Bytecode from a previous run skips the parser entirely.
+		CachedAsset cached;
+		if (cache && cache->Load(AssetCache::Kind::LuaBytecode, resolvedPath, cached) && cached.format == luacompat::kBytecodeFormat)
+		{
+			compiled.bytecode.assign(reinterpret_cast<const char*>(cached.payload.data()), cached.payload.size());
+		}
+		else
+		{
+			sol::load_result loadResult = engine->script->lua.load_file(resolvedPath);
+			if (!loadResult.valid()) {
+				sol::error err = loadResult;
+				spdlog::error("Failed to compile '{}': {}", resolvedPath, err.what());
+				return nullptr;
+			}
+
+			sol::function chunk = loadResult;
+			sol::bytecode dumped = chunk.dump();
+			compiled.bytecode.assign(reinterpret_cast<const char*>(dumped.data()), dumped.size());
+
+			if (cache)
+			{
+				cached.format = luacompat::kBytecodeFormat;
+				cached.payload.assign(compiled.bytecode.begin(), compiled.bytecode.end());
+				cache->Store(AssetCache::Kind::LuaBytecode, resolvedPath, cached);
+			}
+		}
+
+		return &compiledLua.insert_or_assign(resolvedPath, std::move(compiled)).first->second.bytecode;
+	}
 	bool ResourceManager::DeleteScript(const std::string& name)
 	{
 		if (engine->script->scripts.contains(name))
@@ -128,4 +282,69 @@ namespace willengine
 		spdlog::error("following script isn't included in the scripts: " + name);
 		return false;
 	}
+
+	void ResourceManager::StartHotReload()
+	{
+		if (!watcher) {
+			watcher = std::make_unique<FileWatcher>();
+		}
+		watcher->Start(rootPath);
+	}
+
+	void ResourceManager::StopHotReload()
+	{
+		if (watcher) {
+			watcher->Stop();
+		}
+	}
+
+	void ResourceManager::ProcessHotReload()
+	{
+		WILLENGINE_TRACE_ZONE("Resource::ProcessHotReload");
+		if (!watcher || !watcher->IsRunning()) return;
+
+		std::vector<std::filesystem::path> changed;
+		watcher->PollChanges(changed);
+
+		for (const std::filesystem::path& path : changed) {
+			ReloadAsset(path);
+		}
+	}
+
+	bool ResourceManager::ReloadAsset(const std::filesystem::path& changedPath)
+	{
+		// e.g. "sprites/player_ship.png"
+		std::filesystem::path assetRelative = std::filesystem::relative(changedPath, rootPath);
+		auto part = assetRelative.begin();
+		if (part == assetRelative.end()) return false;
+
+		// Asset names are relative to their folder without the extension, the same as SceneManager's auto-loading.
+		const std::string folder = part->string();
+		std::filesystem::path namePath;
+		for (++part; part != assetRelative.end(); ++part) {
+			namePath /= *part;
+		}
+		const std::string extension = namePath.extension().string();
+		const std::string name = namePath.replace_extension("").string();
+		if (name.empty()) return false;
+
+		if (folder == "scripts" && extension == ".lua")
+		{
+			if (namePath.begin()->string() == "config") {
+				spdlog::info("Scene file '{}' changed, it will be applied on the next scene load", name);
+				return false;
+			}
+			if (!LoadScript(name, assetRelative.string())) return false;
+			return engine->script->ReloadScript(name);
+		}
+		if (folder == "sprites" && extension == ".png")
+		{
+			return LoadTexture(name, assetRelative.string());
+		}
+		if (folder == "sounds" && IsSoundExtension(extension))
+		{
+			return LoadSound(name, assetRelative.string());
+		}
+		return false;
+	}
 }
@@ -1,33 +1,67 @@
 #pragma once
 #include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <Types.h>
+#include "../Engine.h"
 
 /* TODO: Do The Extensions on the class.*/
 namespace willengine
 {
 	class Engine;
+	class FileWatcher;
+	class AssetCache;
 
 	class ResourceManager
 	{
 		//typedef std::function<void()> UpdateCallback; ??
 	public:
 		ResourceManager(Engine* engine);
-		~ResourceManager() = default;
+		~ResourceManager();
+
+		void Startup(Engine::Config& config);
 
 		std::string ResolvePath(const std::string& relativePath);
 		void SetRootPath(const std::string& rootPath);
 
-		bool LoadSound(const std::string& name, const std::string& relativePath);
+		// Sounds at least this big are streamed from disk instead of decoded into memory.
+		static constexpr uintmax_t kStreamingThresholdBytes = 1024 * 1024;
+		static bool IsSoundExtension(const std::string& extension);
+
+		bool LoadSound(const std::string& name, const std::string& relativePath, bool stream = false);
 		bool DeleteSound(const std::string& name);
 
 		bool LoadScript(const std::string& name, const std::string& relativePath);
 		bool DeleteScript(const std::string& name);
 
+		// A Lua file compiled to bytecode. Each version of a file is parsed at most once per process,
+		// or not at all when the asset cache has it. Null if the file doesn't compile.
+		const std::string* GetLuaBytecode(const std::string& resolvedPath);
+
 		bool LoadTexture(const std::string& name, const std::string& relativePath);
 		bool DeleteTexture(const std::string& name);
+
+		// Hot reload: watch the assets folder and re-import changed files.
+		void StartHotReload();
+		void StopHotReload();
+		// Re-imports the files changed since the last call. Call it at a frame boundary.
+		void ProcessHotReload();
 	private:
+		bool ReloadAsset(const std::filesystem::path& changedPath);
+
+		struct CompiledLua
+		{
+			std::filesystem::file_time_type writeTime;
+			uintmax_t size = 0;
+			std::string bytecode;
+		};
+
 		Engine* engine;
 		std::filesystem::path rootPath;
+		std::unique_ptr<FileWatcher> watcher;
+		std::unique_ptr<AssetCache> cache;	// null when Config::asset_cache is off
+		std::unordered_map<std::string, CompiledLua> compiledLua;	// resolved path -> bytecode
 	};
 
 }
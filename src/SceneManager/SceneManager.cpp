@@ -146,7 +146,7 @@ namespace willengine
 
         for (const auto& entry : std::filesystem::recursive_directory_iterator(soundsDir))
         {
-            if (entry.is_regular_file() && entry.path().extension() == ".wav")
+            if (entry.is_regular_file() && ResourceManager::IsSoundExtension(entry.path().extension().string()))
             {
                 // Get path relative to scripts folder for the name
                 std::filesystem::path relativePath = std::filesystem::relative(entry.path(), soundsPath);
@@ -197,10 +197,9 @@ namespace willengine
         std::string resolvedPath = engine->resource->ResolvePath(path);
 
         // Execute the scene file to get the Scene table
-        sol::protected_function_result result = engine->script->lua.script_file(resolvedPath);
-        if (!result.valid()) {
-            sol::error err = result;
-            spdlog::error("Failed to load scene '{}': {}", path, err.what());
+        std::string error;
+        if (!engine->script->RunChunk(engine->script->lua, resolvedPath, nullptr, error)) {
+            spdlog::error("Failed to load scene '{}': {}", path, error);
             return false;
         }
 
@@ -230,7 +229,7 @@ namespace willengine
             if (idOpt) {
                 std::string entityName = idOpt->get_or<std::string>("entityID", "");
                 if (!entityName.empty()) {
-                    engine->script->lua[entityName] = entity;  // Makes "player" available in Lua
+                    engine->script->SetEntityGlobal(entityName, entity);  // Makes "player" available in Lua
                     namedEntities[entityName] = entity;
                     spdlog::info("Registered entity '{}' with ID {}", entityName, entity);
                 }
@@ -303,7 +302,7 @@ namespace willengine
 
         // Register entity name in Lua if provided
         if (!data.entityID.empty()) {
-            engine->script->lua[data.entityID] = entity;
+            engine->script->SetEntityGlobal(data.entityID, entity);
             namedEntities[data.entityID] = entity;
             spdlog::info("Created entity '{}' with ID {}", data.entityID, entity);
         }
@@ -0,0 +1,80 @@
+#pragma once
+#include "SolConfig.h"
+/*
+    The scripting runtime is either reference Lua 5.4 or LuaJIT (Lua 5.1 API), picked with
+    WILLENGINE_LUA_BACKEND in CMake. This is where the engine code papers over the differences.
+
+    Environments: script isolation goes through sol::environment, which sol2 maps to _ENV
+    upvalues on 5.4 and to setfenv on LuaJIT, so InitializeEntityScript is the same on both.
+    Scripts must not rely on `_ENV` directly; use the globals they were given.
+*/
+#if defined(WILLENGINE_LUAJIT)
+#include <luajit.h>
+#endif
+
+namespace willengine::luacompat
+{
+#if defined(WILLENGINE_LUAJIT)
+	inline constexpr const char* kBackendName = LUAJIT_VERSION;
+	// Stored with cached bytecode; LuaJIT and PUC Lua bytecode are not interchangeable.
+	inline constexpr int kBytecodeFormat = LUAJIT_VERSION_NUM;
+#else
+	inline constexpr const char* kBackendName = LUA_RELEASE;
+	inline constexpr int kBytecodeFormat = LUA_VERSION_NUM;
+#endif
+
+	// lua_getfield only returns the value's type from 5.3 on.
+	inline int GetField(lua_State* L, int index, const char* key)
+	{
+		lua_getfield(L, index, key);
+		return lua_type(L, -1);
+	}
+
+	// Generational collection only exists from Lua 5.4 on.
+	inline constexpr bool kHasGenerationalGC = LUA_VERSION_NUM >= 504;
+
+	// Switches the collector mode.
+	inline bool SetGenerationalGC(lua_State* L, bool generational)
+	{
+#if LUA_VERSION_NUM >= 504
+		// The modes take different argument counts (LUA_GCINC reads pause, stepmul and stepsize); 0 keeps each default.
+		if (generational) {
+			lua_gc(L, LUA_GCGEN, 0, 0);
+		}
+		else {
+			lua_gc(L, LUA_GCINC, 0, 0, 0);
+		}
+		return true;
+#else
+		(void)L;
+		return !generational;
+#endif
+	}
+
+	// One collector step of about `kilobytes` of work. Returns true when it finished a cycle.
+	// 5.1 restarts a stopped collector on a step, so stop it again if asked.
+	inline bool StepGC(lua_State* L, int kilobytes, bool keepStopped)
+	{
+		const bool finished = lua_gc(L, LUA_GCSTEP, kilobytes) != 0;
+#if LUA_VERSION_NUM < 502
+		if (keepStopped) lua_gc(L, LUA_GCSTOP, 0);
+#else
+		(void)keepStopped;
+#endif
+		return finished;
+	}
+
+	// Opens the backend-specific libraries on top of the standard ones. ffi gives scripts unrestricted
+	// native calls, so it is only opened when the build asks for it (WILLENGINE_LUAJIT_FFI).
+	inline void OpenBackendLibraries(sol::state& lua)
+	{
+#if defined(WILLENGINE_LUAJIT)
+		lua.open_libraries(sol::lib::jit, sol::lib::bit32);
+#if defined(WILLENGINE_LUAJIT_FFI)
+		lua.open_libraries(sol::lib::ffi);
+#endif
+#else
+		(void)lua;
+#endif
+	}
+}
@@ -1,20 +1,212 @@
 #include "ScriptManager.h"
+#include "LuaCompat.h"
 #include "../Engine.h"
 #include "../ResourceManager/ResourceManager.h"
 #include "../InputManager/InputManager.h"
 #include "../GraphicsManager/GraphicsManager.h"
 #include "../SoundManager/SoundManager.h"
+#include "../PhysicsManager/PhysicsManager.h"
+#include "../Tracing/Trace.h"
 #include <spdlog/spdlog.h>
 #include <unordered_set>
+#include <algorithm>
+#include <chrono>
+#include <array>
 namespace willengine
 {
+    namespace
+    {
+        /*
+            Float columns a component exposes to Lua for bulk access (ECS.Read<Name>/ECS.Write<Name>).
+            Only components with a specialization get the bulk API.
+        */
+        template<typename T>
+        struct LuaColumns
+        {
+            static constexpr int count = 0;
+        };
+
+        template<>
+        struct LuaColumns<Rigidbody>
+        {
+            static constexpr int count = 4;
+            static constexpr const char* names[count] = { "px", "py", "vx", "vy" };
+            static float& Get(Rigidbody& rb, int column) { return column < 2 ? rb.position[column] : rb.velocity[column - 2]; }
+        };
+
+        template<>
+        struct LuaColumns<Transform>
+        {
+            static constexpr int count = 2;
+            static constexpr const char* names[count] = { "x", "y" };
+            static float& Get(Transform& transform, int column) { return transform[column]; }
+        };
+
+        template<>
+        struct LuaColumns<Velocity>
+        {
+            static constexpr int count = 2;
+            static constexpr const char* names[count] = { "x", "y" };
+            static float& Get(Velocity& velocity, int column) { return velocity[column]; }
+        };
+
+        // Leaves `out[field]` on the stack, creating it as a table if it isn't one.
+        void GetOrCreateArray(lua_State* L, int out, const char* field)
+        {
+            if (luacompat::GetField(L, out, field) != LUA_TTABLE) {
+                lua_pop(L, 1);
+                lua_newtable(L);
+                lua_pushvalue(L, -1);
+                lua_setfield(L, out, field);
+            }
+        }
+
+        /*
+            ECS.Read<Name>([columns]) -> columns
+            Copies every T into flat arrays: columns.entity[i], columns.<column>[i] for i = 1..columns.n.
+            Passing last tick's table back in reuses its arrays instead of allocating new ones.
+            A copy, not a view of the ECS: each call costs one table store per entity and column, and
+            Write<Name> one load per entity and column back. That is cheap next to a Lua call per
+            component, but a script that touches a few entities should use Get<Name> instead.
+        */
+        template<typename T>
+        int LuaReadColumns(lua_State* L)
+        {
+            ECS* ecs = static_cast<ECS*>(lua_touserdata(L, lua_upvalueindex(1)));
+            if (lua_istable(L, 1)) {
+                lua_settop(L, 1);
+            }
+            else {
+                lua_settop(L, 0);
+                lua_createtable(L, 0, LuaColumns<T>::count + 2);
+            }
+
+            GetOrCreateArray(L, 1, "entity");
+            for (int column = 0; column < LuaColumns<T>::count; ++column) {
+                GetOrCreateArray(L, 1, LuaColumns<T>::names[column]);
+            }
+
+            lua_Integer n = 0;
+            ecs->ForEachComponent<T>([&](entityID entity, T& component) {
+                ++n;
+                lua_pushinteger(L, entity);
+                lua_rawseti(L, 2, n);
+                for (int column = 0; column < LuaColumns<T>::count; ++column) {
+                    lua_pushnumber(L, LuaColumns<T>::Get(component, column));
+                    lua_rawseti(L, 3 + column, n);
+                }
+                });
+
+            lua_pushinteger(L, n);
+            lua_setfield(L, 1, "n");
+            lua_settop(L, 1);
+            return 1;
+        }
+
+        void SetClosure(sol::table& table, const char* name, lua_CFunction function, void* upvalue)
+        {
+            lua_State* L = table.lua_state();
+            table.push();
+            lua_pushlightuserdata(L, upvalue);
+            lua_pushcclosure(L, function, 1);
+            lua_setfield(L, -2, name);
+            lua_pop(L, 1);
+        }
+    }
+
+#if WILLENGINE_FAST_BINDINGS
+    namespace
+    {
+        /*
+            Release-profile trampolines for the bindings scripts call thousands of times per tick.
+            They are plain lua_CFunctions: arguments are read without type checks and nothing throws.
+            The engine object they need is passed as a light userdata upvalue.
+        */
+        template<bool (InputManager::*Query)(int) const>
+        int FastInputQuery(lua_State* L)
+        {
+            const InputManager* input = static_cast<const InputManager*>(lua_touserdata(L, lua_upvalueindex(1)));
+            lua_pushboolean(L, (input->*Query)(int(lua_tointeger(L, 1))));
+            return 1;
+        }
+
+        int FastVec2Add(lua_State* L)
+        {
+            const glm::vec2& a = sol::stack::unqualified_get<glm::vec2&>(L, 1);
+            const glm::vec2& b = sol::stack::unqualified_get<glm::vec2&>(L, 2);
+            return sol::stack::push(L, a + b);
+        }
+
+        int FastVec2Sub(lua_State* L)
+        {
+            const glm::vec2& a = sol::stack::unqualified_get<glm::vec2&>(L, 1);
+            const glm::vec2& b = sol::stack::unqualified_get<glm::vec2&>(L, 2);
+            return sol::stack::push(L, a - b);
+        }
+
+        // Replaces the three-way sol::overload: dispatch on which operand is a number.
+        int FastVec2Mul(lua_State* L)
+        {
+            if (lua_type(L, 2) == LUA_TNUMBER) {
+                const glm::vec2& v = sol::stack::unqualified_get<glm::vec2&>(L, 1);
+                return sol::stack::push(L, v * float(lua_tonumber(L, 2)));
+            }
+            if (lua_type(L, 1) == LUA_TNUMBER) {
+                const glm::vec2& v = sol::stack::unqualified_get<glm::vec2&>(L, 2);
+                return sol::stack::push(L, float(lua_tonumber(L, 1)) * v);
+            }
+            const glm::vec2& a = sol::stack::unqualified_get<glm::vec2&>(L, 1);
+            const glm::vec2& b = sol::stack::unqualified_get<glm::vec2&>(L, 2);
+            return sol::stack::push(L, a * b);
+        }
+    }
+
+    void ScriptManager::BindFastPaths(sol::table& input_namespace)
+    {
+        SetClosure(input_namespace, "KeyHoldingDown", &FastInputQuery<&InputManager::KeyIsPressedInFrame>, engine->input);
+        SetClosure(input_namespace, "KeyJustPressed", &FastInputQuery<&InputManager::KeyJustPressed>, engine->input);
+        SetClosure(input_namespace, "KeyReleased", &FastInputQuery<&InputManager::KeyJustReleased>, engine->input);
+    }
+#endif
+
+    namespace
+    {
+        const char* const kScriptFunctionNames[] = { "Start", "Update", "UpdateAll", "OnCollision", "OnCollisionEnd" };
+        // Only its address matters: it is the registry key under which each state's Shard is stored.
+        const char kProfilerRegistryKey = 0;
+    }
+
 	ScriptManager::ScriptManager(Engine* engine) :engine(engine)
 	{
 	}
 
-	void ScriptManager::Startup()
+	void ScriptManager::Startup(Engine::Config& config)
 	{
-		lua.open_libraries(sol::lib::base, sol::lib::math, sol::lib::table,sol::lib::os, sol::lib::string, sol::lib::io, sol::lib::debug);
+        gcBudgetMs = config.lua_gc_budget_ms;
+        gcStepKB = std::max(config.lua_gc_step_kb, 1);
+        gcGenerational = config.lua_gc_generational && luacompat::kHasGenerationalGC;
+        spdlog::info("Scripting runtime: {}", luacompat::kBackendName);
+
+        // Shard 0 is the main state. Extra shards get their own state, each with the full engine API.
+        const uint32_t shardCount = uint32_t(std::max(config.script_threads, 1));
+        if (shardCount > 1) {
+            spdlog::info("{} parallel Lua states: ECS.Get<Name> returns copies during Update, fetch components there instead of keeping them from Start", shardCount);
+        }
+        for (uint32_t i = 0; i < shardCount; ++i) {
+            auto shard = std::make_unique<Shard>();
+            shard->owner = this;
+            shard->index = i;
+            if (i == 0) {
+                shard->lua = &lua;
+            }
+            else {
+                shard->ownedState = std::make_unique<sol::state>();
+                shard->lua = shard->ownedState.get();
+            }
+            InitializeShard(*shard, config);
+            BindEngineAPI(*shard);
+            shards.push_back(std::move(shard));
+        }
 
         // Load the debugger
         /*
@@ -24,7 +216,48 @@ namespace willengine
         std::string debuggerPath = engine->resource->ResolvePath("scripts/debugger.lua");
         lua.require_file("dbg", debuggerPath);
 
+        if (shardCount > 1) {
+            workersRunning = true;
+            for (uint32_t i = 1; i < shardCount; ++i) {
+                workers.emplace_back(&ScriptManager::WorkerLoop, this, i);
+            }
+            spdlog::info("Entity scripts run on {} Lua states", shardCount);
+        }
+	}
+
+    void ScriptManager::InitializeShard(Shard& shard, Engine::Config& config)
+    {
+        sol::state& lua = *shard.lua;
+		lua.open_libraries(sol::lib::base, sol::lib::math, sol::lib::table,sol::lib::os, sol::lib::string, sol::lib::io, sol::lib::debug);
+        luacompat::OpenBackendLibraries(lua);
+
+        // Count every byte Lua allocates, for the profiler. The hook finds its shard through the registry.
+        shard.baseAlloc = lua_getallocf(lua.lua_state(), &shard.baseAllocData);
+        lua_setallocf(lua.lua_state(), &ScriptManager::CountingAlloc, &shard);
+        lua_pushlightuserdata(lua.lua_state(), const_cast<char*>(&kProfilerRegistryKey));
+        lua_pushlightuserdata(lua.lua_state(), &shard);
+        lua_rawset(lua.lua_state(), LUA_REGISTRYINDEX);
+
+        // Garbage collector mode and budget
+        if (!luacompat::SetGenerationalGC(lua.lua_state(), config.lua_gc_generational) && shard.index == 0) {
+            spdlog::warn("Generational Lua GC isn't available on {}, using incremental", luacompat::kBackendName);
+        }
+        if (gcBudgetMs > 0.0) {
+            // Collection only happens in StepGarbageCollector from now on.
+            lua_gc(lua.lua_state(), LUA_GCSTOP, 0);
+        }
+
+        shard.random.Seed(config.random_seed, shard.index);
+        if (config.deterministic) {
+            // Lua 5.4 seeds math.random from the clock. Scripts that use it get a fixed sequence too.
+            sol::protected_function randomseed = lua["math"]["randomseed"];
+            randomseed(double(uint32_t(config.random_seed + shard.index)));
+        }
+    }
 
+    void ScriptManager::BindEngineAPI(Shard& shard)
+    {
+        sol::state& lua = *shard.lua;
 
         /* 
             Lua namespaces organize lua scripting syntax as following; 
@@ -48,222 +281,245 @@ namespace willengine
         // Expose the KeyIsPressed function to Lua
         input_namespace["KeyHoldingDown"] = [this](int keycode) 
             {
-            return engine->input->KeyIsPressedInFrame(static_cast<InputManager::Key>(keycode));
+            return engine->input->KeyIsPressedInFrame(keycode);
             };
         input_namespace["KeyReleased"] = [this](int keycode)
             {
-                return engine->input->KeyJustReleased((static_cast<InputManager::Key>(keycode)));
+                return engine->input->KeyJustReleased(keycode);
             };
         input_namespace["KeyJustPressed"] = [this](int keycode)
             {
-                return engine->input->KeyJustPressed((static_cast<InputManager::Key>(keycode)));
+                return engine->input->KeyJustPressed(keycode);
+            };
+        input_namespace["MouseButtonHoldingDown"] = [this](int button)
+            {
+                return engine->input->MouseButtonIsPressed(button);
+            };
+        input_namespace["MouseButtonJustPressed"] = [this](int button)
+            {
+                return engine->input->MouseButtonJustPressed(button);
+            };
+        input_namespace["MouseButtonReleased"] = [this](int button)
+            {
+                return engine->input->MouseButtonJustReleased(button);
+            };
+        input_namespace["MousePosition"] = [this]()
+            {
+                vec2 position = engine->input->GetMousePosition();
+                return std::make_tuple(position.x, position.y);
+            };
+        input_namespace["GamepadButtonHoldingDown"] = [this](int button)
+            {
+                return engine->input->GamepadButtonIsPressed(button);
             };
+        input_namespace["GamepadButtonJustPressed"] = [this](int button)
+            {
+                return engine->input->GamepadButtonJustPressed(button);
+            };
+        input_namespace["GamepadAxis"] = [this](int axis)
+            {
+                return engine->input->GetGamepadAxis(axis);
+            };
+
+        // Expose keyboard constants to Lua (GLFW key codes, any of them can be queried)
+        sol::table keyboard = lua.create_table();
+        for (char c = 'A'; c <= 'Z'; ++c) {
+            keyboard[std::string(1, c)] = int(c);
+        }
+        for (char c = '0'; c <= '9'; ++c) {
+            keyboard["NUM" + std::string(1, c)] = int(c);
+        }
+        for (int i = 0; i < 12; ++i) {
+            keyboard["F" + std::to_string(i + 1)] = GLFW_KEY_F1 + i;
+        }
+        keyboard["SPACE"] = GLFW_KEY_SPACE;
+        keyboard["ESC"] = GLFW_KEY_ESCAPE;
+        keyboard["ENTER"] = GLFW_KEY_ENTER;
+        keyboard["TAB"] = GLFW_KEY_TAB;
+        keyboard["BACKSPACE"] = GLFW_KEY_BACKSPACE;
+        keyboard["LEFT"] = GLFW_KEY_LEFT;
+        keyboard["RIGHT"] = GLFW_KEY_RIGHT;
+        keyboard["UP"] = GLFW_KEY_UP;
+        keyboard["DOWN"] = GLFW_KEY_DOWN;
+        keyboard["LEFT_SHIFT"] = GLFW_KEY_LEFT_SHIFT;
+        keyboard["RIGHT_SHIFT"] = GLFW_KEY_RIGHT_SHIFT;
+        keyboard["LEFT_CONTROL"] = GLFW_KEY_LEFT_CONTROL;
+        keyboard["RIGHT_CONTROL"] = GLFW_KEY_RIGHT_CONTROL;
+        keyboard["LEFT_ALT"] = GLFW_KEY_LEFT_ALT;
+        keyboard["RIGHT_ALT"] = GLFW_KEY_RIGHT_ALT;
+        lua["KEYBOARD"] = keyboard;
+
+        lua.new_enum<int>("MOUSE", {
+            { "LEFT", GLFW_MOUSE_BUTTON_LEFT },
+            { "RIGHT", GLFW_MOUSE_BUTTON_RIGHT },
+            { "MIDDLE", GLFW_MOUSE_BUTTON_MIDDLE }
+            });
 
-        // Expose keyboard constants to Lua
-        lua.new_enum<int>("KEYBOARD", {
-            { "W", InputManager::Key::W },
-            { "A", InputManager::Key::A },
-            { "S", InputManager::Key::S },
-            { "D", InputManager::Key::D },
-            { "SPACE", InputManager::Key::SPACE },
-            { "ESC", InputManager::Key::ESC }
+        lua.new_enum<int>("GAMEPAD", {
+            { "A", GLFW_GAMEPAD_BUTTON_A },
+            { "B", GLFW_GAMEPAD_BUTTON_B },
+            { "X", GLFW_GAMEPAD_BUTTON_X },
+            { "Y", GLFW_GAMEPAD_BUTTON_Y },
+            { "LEFT_BUMPER", GLFW_GAMEPAD_BUTTON_LEFT_BUMPER },
+            { "RIGHT_BUMPER", GLFW_GAMEPAD_BUTTON_RIGHT_BUMPER },
+            { "BACK", GLFW_GAMEPAD_BUTTON_BACK },
+            { "START", GLFW_GAMEPAD_BUTTON_START },
+            { "DPAD_UP", GLFW_GAMEPAD_BUTTON_DPAD_UP },
+            { "DPAD_RIGHT", GLFW_GAMEPAD_BUTTON_DPAD_RIGHT },
+            { "DPAD_DOWN", GLFW_GAMEPAD_BUTTON_DPAD_DOWN },
+            { "DPAD_LEFT", GLFW_GAMEPAD_BUTTON_DPAD_LEFT },
+            { "LEFT_X", GLFW_GAMEPAD_AXIS_LEFT_X },
+            { "LEFT_Y", GLFW_GAMEPAD_AXIS_LEFT_Y },
+            { "RIGHT_X", GLFW_GAMEPAD_AXIS_RIGHT_X },
+            { "RIGHT_Y", GLFW_GAMEPAD_AXIS_RIGHT_Y },
+            { "LEFT_TRIGGER", GLFW_GAMEPAD_AXIS_LEFT_TRIGGER },
+            { "RIGHT_TRIGGER", GLFW_GAMEPAD_AXIS_RIGHT_TRIGGER }
             });
         lua["Input"] = input_namespace;
 
         // Expose the Shutdown function
-        lua.set_function("Stop", [this]()
+        lua.set_function("Stop", [this, &shard]()
             {
-                engine->Stop();
+                RunOrDefer(shard, [this]() { engine->Stop(); });
             });
 
 
 
         auto graphics_namespace = lua.create_table();
-        graphics_namespace["LoadImage"] = [this](const std::string& name, const std::string& path)
+        graphics_namespace["LoadImage"] = [this, &shard](const std::string& name, const std::string& path)
             {
-                const std::string& resolvedPath = engine->resource->ResolvePath(path);
-                engine->resource->LoadTexture(name, path);
+                RunOrDefer(shard, [this, name, path]() { engine->resource->LoadTexture(name, path); });
             };
 
         lua["Graphics"] = graphics_namespace;
 
         auto resource_namespace = lua.create_table();
-        resource_namespace["LoadScript"] = [this](const std::string& name, const std::string& path)
+        resource_namespace["LoadScript"] = [this, &shard](const std::string& name, const std::string& path)
             {
-                const std::string& resolvedPath = engine->resource->ResolvePath(path);
-                engine->resource->LoadScript(name, resolvedPath);
+                RunOrDefer(shard, [this, name, path]() {
+                    const std::string& resolvedPath = engine->resource->ResolvePath(path);
+                    engine->resource->LoadScript(name, resolvedPath);
+                    });
             };
         lua["Resource"] = resource_namespace;
 
         auto ecs_namespace = lua.create_table();
+        // Entity IDs are handed out atomically, so this is safe from any shard. Components added to
+        // a new entity from a parallel shard only show up once the tick's deferred writes have run.
         ecs_namespace["CreateEntity"] = [this]()
             {
                 return engine->ecs.Create();
             };
-        // AddComponent overloads for each component type
-        ecs_namespace["AddComponent"] = sol::overload(
-            // Transform component
-            [this](entityID entity, Transform component)
+        // Get<Name>/Has<Name>/Remove<Name> for every type in ComponentTypes.
+        // ECS.AddComponent is bound at the end of Startup, once the component usertypes exist.
+        std::apply([&](auto... components) {
+            (BindComponent<decltype(components)>(shard, ecs_namespace), ...);
+            }, ComponentTypes{});
+
+        // DestroyEntity - destroy an entity and all its components
+        ecs_namespace["DestroyEntity"] = [this, &shard](entityID entity) {
+            RunOrDefer(shard, [this, entity]() {
+                engine->ecs.Destroy(entity);
+                RemoveEntityScript(entity);
+                });
+        };
+
+#if WILLENGINE_FAST_BINDINGS
+        // Overwrite the hottest of the bindings above with unchecked trampolines.
+        BindFastPaths(input_namespace);
+#endif
+
+        lua["ECS"] = ecs_namespace;
+
+        // Sound commands go through a single-producer queue, so parallel shards defer them too.
+        auto sound_namespace = lua.create_table();
+        sound_namespace["LoadSound"] = [this, &shard](const std::string& name, const std::string& path)
+            {
+                RunOrDefer(shard, [this, name, path]() { engine->resource->LoadSound(name, path); });
+            };
+        sound_namespace["DeleteSound"] = [this, &shard](const std::string& name)
             {
-                engine->ecs.Get<Transform>(entity) = component;
-            },
-            // Sprite component
-            [this](entityID entity, Sprite component)
+                RunOrDefer(shard, [this, name]() { engine->resource->DeleteSound(name); });
+            };
+        sound_namespace["Play"] = [this, &shard](const std::string& name)
             {
-                engine->ecs.Get<Sprite>(entity) = component;
-            },
-            // Rigidbody component
-            [this](entityID entity, Rigidbody component)
+                RunOrDefer(shard, [this, name]() { engine->sound->PlaySound(name); });
+            };
+        // Resolve the name once, then play by ID: no string hashing on the hot path.
+        sound_namespace["GetID"] = [this](const std::string& name)
             {
-                engine->ecs.Get<Rigidbody>(entity) = component;
-            },
-            // Velocity component
-            [this](entityID entity, Velocity component)
+                return engine->sound->GetSoundID(name);
+            };
+        sound_namespace["PlayID"] = [this, &shard](soundID sound)
             {
-                engine->ecs.Get<Velocity>(entity) = component;
-            },
-            // Health component
-            [this](entityID entity, Health component)
+                RunOrDefer(shard, [this, sound]() { engine->sound->PlaySound(sound); });
+            };
+        sound_namespace["Stop"] = [this, &shard](soundID sound)
             {
-                engine->ecs.Get<Health>(entity) = component;
-            },
-            // Gravity component
-            [this](entityID entity, Gravity component)
+                RunOrDefer(shard, [this, sound]() { engine->sound->StopSound(sound); });
+            };
+        sound_namespace["SetVolume"] = [this, &shard](soundID sound, float volume)
             {
-                engine->ecs.Get<Gravity>(entity) = component;
-            },
-            // Script component
-            [this](entityID entity, Script component)
+                RunOrDefer(shard, [this, sound, volume]() { engine->sound->SetVolume(sound, volume); });
+            };
+        sound_namespace["SetPan"] = [this, &shard](soundID sound, float pan)
             {
-                engine->ecs.Get<Script>(entity) = component;
-            },
-            [this](entityID entity, BoxCollider component)
+                RunOrDefer(shard, [this, sound, pan]() { engine->sound->SetPan(sound, pan); });
+            };
+        sound_namespace["SetMaxInstances"] = [this, &shard](soundID sound, int maxInstances)
             {
-                engine->ecs.Get<BoxCollider>(entity) = component;
-            }
-        );
-
-        // GetComponent - returns pointer to component (nil if not found)
-        ecs_namespace["GetTransform"] = [this](entityID entity) -> Transform* {
-            if (engine->ecs.Has<Transform>(entity)) {
-                return &engine->ecs.Get<Transform>(entity);
-            }
-            return nullptr;
-        };
-        ecs_namespace["GetSprite"] = [this](entityID entity) -> Sprite* {
-            if (engine->ecs.Has<Sprite>(entity)) {
-                return &engine->ecs.Get<Sprite>(entity);
-            }
-            return nullptr;
-        };
-        ecs_namespace["GetRigidbody"] = [this](entityID entity) -> Rigidbody* {
-            if (engine->ecs.Has<Rigidbody>(entity)) {
-                return &engine->ecs.Get<Rigidbody>(entity);
-            }
-            return nullptr;
-        };
-        ecs_namespace["GetVelocity"] = [this](entityID entity) -> Velocity* {
-            if (engine->ecs.Has<Velocity>(entity)) {
-                return &engine->ecs.Get<Velocity>(entity);
-            }
-            return nullptr;
-        };
-        ecs_namespace["GetHealth"] = [this](entityID entity) -> Health* {
-            if (engine->ecs.Has<Health>(entity)) {
-                return &engine->ecs.Get<Health>(entity);
-            }
-            return nullptr;
-        };
-        ecs_namespace["GetGravity"] = [this](entityID entity) -> Gravity* {
-            if (engine->ecs.Has<Gravity>(entity)) {
-                return &engine->ecs.Get<Gravity>(entity);
-            }
-            return nullptr;
-        };
-        ecs_namespace["GetScript"] = [this](entityID entity) -> Script* {
-            if (engine->ecs.Has<Script>(entity)) {
-                return &engine->ecs.Get<Script>(entity);
-            }
-            return nullptr;
-        };
-        ecs_namespace["GetBoxCollider"] = [this](entityID entity) -> BoxCollider* {
-            if (engine->ecs.Has<BoxCollider>(entity)) {
-                return &engine->ecs.Get<BoxCollider>(entity);
-            }
-            return nullptr;
+                RunOrDefer(shard, [this, sound, maxInstances]() { engine->sound->SetMaxInstances(sound, maxInstances); });
             };
-
-
-        // HasComponent - check if entity has a component
-        ecs_namespace["HasTransform"] = [this](entityID entity) {
-            return engine->ecs.Has<Transform>(entity);
-        };
-        ecs_namespace["HasSprite"] = [this](entityID entity) {
-            return engine->ecs.Has<Sprite>(entity);
-        };
-        ecs_namespace["HasRigidbody"] = [this](entityID entity) {
-            return engine->ecs.Has<Rigidbody>(entity);
-        };
-        ecs_namespace["HasVelocity"] = [this](entityID entity) {
-            return engine->ecs.Has<Velocity>(entity);
-        };
-        ecs_namespace["HasHealth"] = [this](entityID entity) {
-            return engine->ecs.Has<Health>(entity);
-        };
-        ecs_namespace["HasGravity"] = [this](entityID entity) {
-            return engine->ecs.Has<Gravity>(entity);
-        };
-        ecs_namespace["HasScript"] = [this](entityID entity) {
-            return engine->ecs.Has<Script>(entity);
-        };
-        ecs_namespace["HasBoxCollider"] = [this](entityID entity) {
-            return engine->ecs.Has<BoxCollider>(entity);
+        sound_namespace["SetPriority"] = [this, &shard](soundID sound, int priority)
+            {
+                RunOrDefer(shard, [this, sound, priority]() { engine->sound->SetPriority(sound, priority); });
             };
+        lua["Sound"] = sound_namespace;
 
-        // RemoveComponent - remove a component from an entity
-        ecs_namespace["RemoveTransform"] = [this](entityID entity) {
-            engine->ecs.Drop<Transform>(entity);
-        };
-        ecs_namespace["RemoveSprite"] = [this](entityID entity) {
-            engine->ecs.Drop<Sprite>(entity);
-        };
-        ecs_namespace["RemoveRigidbody"] = [this](entityID entity) {
-            engine->ecs.Drop<Rigidbody>(entity);
-        };
-        ecs_namespace["RemoveVelocity"] = [this](entityID entity) {
-            engine->ecs.Drop<Velocity>(entity);
-        };
-        ecs_namespace["RemoveHealth"] = [this](entityID entity) {
-            engine->ecs.Drop<Health>(entity);
-        };
-        ecs_namespace["RemoveGravity"] = [this](entityID entity) {
-            engine->ecs.Drop<Gravity>(entity);
-        };
-        ecs_namespace["RemoveScript"] = [this](entityID entity) {
-            engine->ecs.Drop<Script>(entity);
-        };
-
-        // DestroyEntity - destroy an entity and all its components
-        ecs_namespace["DestroyEntity"] = [this](entityID entity) {
-            engine->ecs.Destroy(entity);
-        };
-
-        lua["ECS"] = ecs_namespace;
-
-        auto sound_namespace = lua.create_table();
-        sound_namespace["LoadSound"] = [this](const std::string& name, const std::string& path)
+        // Spatial queries over BoxColliders, as of the last physics update. Read-only, so no deferring.
+        auto physics_namespace = lua.create_table();
+        physics_namespace["QueryAABB"] = [this](const glm::vec2& min, const glm::vec2& max)
             {
-                engine->resource->LoadSound(name, path);
+                std::vector<entityID> found;
+                engine->physics->QueryAABB(AABB(min, max), found);
+                return sol::as_table(std::move(found));
             };
-        sound_namespace["DeleteSound"] = [this](const std::string& name)
+        physics_namespace["QueryPoint"] = [this](const glm::vec2& point)
             {
-                engine->resource->DeleteSound(name);
+                std::vector<entityID> found;
+                engine->physics->QueryPoint(point, found);
+                return sol::as_table(std::move(found));
             };
-        sound_namespace["Play"] = [this](const std::string& name)
+        // entity, distance, point of the closest hit; nil if nothing is hit.
+        physics_namespace["Raycast"] = [this](const glm::vec2& origin, const glm::vec2& direction, float maxDistance, sol::this_state state)
             {
-                engine->sound->PlaySound(name);
+                sol::variadic_results results;
+                PhysicsManager::RaycastHit hit;
+                if (engine->physics->Raycast(origin, direction, maxDistance, hit)) {
+                    results.push_back({ state, sol::in_place, hit.entity });
+                    results.push_back({ state, sol::in_place, hit.distance });
+                    results.push_back({ state, sol::in_place, hit.point });
+                }
+                else {
+                    results.push_back({ state, sol::in_place, sol::lua_nil });
+                }
+                return results;
             };
-        lua["Sound"] = sound_namespace;
+        lua["Physics"] = physics_namespace;
+
+        // Simulation clock. Scripts run once per fixed tick, so DeltaTime() is the same every call.
+        auto time_namespace = lua.create_table();
+        time_namespace["DeltaTime"] = [this]() { return engine->GetTickDelta(); };
+        time_namespace["TickCount"] = [this]() { return engine->GetTickCount(); };
+        lua["Time"] = time_namespace;
+
+        // Seeded from Config::random_seed, one generator per Lua state: a deterministic run draws the same numbers every time.
+        auto random_namespace = lua.create_table();
+        random_namespace["Seed"] = [&shard](lua_Integer seed) { shard.random.Seed(uint64_t(seed), shard.index); };
+        random_namespace["Int"] = [&shard](lua_Integer lo, lua_Integer hi) { return lua_Integer(shard.random.Int(lo, hi)); };
+        random_namespace["Float"] = [&shard]() { return shard.random.Float(); };
+        random_namespace["Range"] = [&shard](float lo, float hi) { return lo + (hi - lo) * shard.random.Float(); };
+        lua["Random"] = random_namespace;
 
 
 
@@ -286,6 +542,11 @@ namespace willengine
             sol::call_constructor, sol::constructors<glm::vec2(), glm::vec2(float), glm::vec2(float, float)>(),
             "x", &glm::vec2::x,
             "y", &glm::vec2::y,
+#if WILLENGINE_FAST_BINDINGS
+            sol::meta_function::addition, &FastVec2Add,
+            sol::meta_function::subtraction, &FastVec2Sub,
+            sol::meta_function::multiplication, &FastVec2Mul
+#else
             // optional and fancy: operator overloading. see: https://github.com/ThePhD/sol2/issues/547
             sol::meta_function::addition, sol::overload([](const glm::vec2& v1, const glm::vec2& v2) -> glm::vec2 { return v1 + v2; }),
             sol::meta_function::subtraction, sol::overload([](const glm::vec2& v1, const glm::vec2& v2) -> glm::vec2 { return v1 - v2; }),
@@ -294,6 +555,7 @@ namespace willengine
                 [](const glm::vec2& v1, float f) -> glm::vec2 { return v1 * f; },
                 [](float f, const glm::vec2& v1) -> glm::vec2 { return f * v1; }
             )
+#endif
         );
 
 
@@ -336,8 +598,236 @@ namespace willengine
             "dimensionSizes", &BoxCollider::dimensionSizes,
             "isCollided", &BoxCollider::isCollided);
 
+        // AddComponent: one metatable lookup picks the typed setter, no overload resolution.
+        std::apply([&](auto... components) {
+            (RegisterComponentAdder<decltype(components)>(shard), ...);
+            }, ComponentTypes{});
+        sol::table ecs = lua["ECS"];
+        ecs.push();
+        lua_pushlightuserdata(lua.lua_state(), &shard);
+        lua_pushcclosure(lua.lua_state(), &ScriptManager::LuaAddComponent, 1);
+        lua_setfield(lua.lua_state(), -2, "AddComponent");
+        lua_pop(lua.lua_state(), 1);
 	}
 
+
+    template<typename F>
+    void ScriptManager::RunOrDefer(Shard& shard, F&& write)
+    {
+        if (shard.deferWrites) {
+            shard.deferred.emplace_back(std::forward<F>(write));
+        }
+        else {
+            write();
+        }
+    }
+
+    // ECS.Write<Name>(columns): writes the columns back, one pass. Entities that lost T since the read are skipped.
+    template<typename T>
+    int ScriptManager::LuaWriteColumns(lua_State* L)
+    {
+        Shard* shard = static_cast<Shard*>(lua_touserdata(L, lua_upvalueindex(1)));
+        ECS* ecs = &shard->owner->engine->ecs;
+        luaL_checktype(L, 1, LUA_TTABLE);
+        lua_settop(L, 1);
+
+        lua_getfield(L, 1, "n");
+        const lua_Integer n = lua_tointeger(L, -1);
+        lua_pop(L, 1);
+
+        lua_getfield(L, 1, "entity");
+        for (int column = 0; column < LuaColumns<T>::count; ++column) {
+            lua_getfield(L, 1, LuaColumns<T>::names[column]);
+        }
+        for (int index = 2; index <= 2 + LuaColumns<T>::count; ++index) {
+            luaL_checktype(L, index, LUA_TTABLE);
+        }
+
+        // Parallel shard: copy the rows out now into the shard's arena, store them when the tick's writes
+        // are replayed. The queued function only holds a pointer to them, so queueing allocates nothing.
+        struct Row
+        {
+            entityID entity;
+            std::array<float, LuaColumns<T>::count> values;
+        };
+        struct DeferredRows
+        {
+            ECS* ecs;
+            Row* rows;
+            size_t count;
+        };
+        DeferredRows* deferred = nullptr;
+        if (shard->deferWrites && n > 0) {
+            deferred = static_cast<DeferredRows*>(shard->deferredArena.Allocate(sizeof(DeferredRows), alignof(DeferredRows)));
+            deferred->ecs = ecs;
+            deferred->rows = static_cast<Row*>(shard->deferredArena.Allocate(size_t(n) * sizeof(Row), alignof(Row)));
+            deferred->count = 0;
+        }
+
+        for (lua_Integer i = 1; i <= n; ++i) {
+            lua_rawgeti(L, 2, i);
+            const entityID entity = entityID(lua_tointeger(L, -1));
+            lua_pop(L, 1);
+            T* component = ecs->TryGet<T>(entity);
+            if (component == nullptr) continue;
+
+            std::array<float, LuaColumns<T>::count> values;
+            for (int column = 0; column < LuaColumns<T>::count; ++column) {
+                lua_rawgeti(L, 3 + column, i);
+                values[column] = float(lua_tonumber(L, -1));
+                lua_pop(L, 1);
+            }
+            if (deferred != nullptr) {
+                deferred->rows[deferred->count++] = Row{ entity, values };
+                continue;
+            }
+            for (int column = 0; column < LuaColumns<T>::count; ++column) {
+                LuaColumns<T>::Get(*component, column) = values[column];
+            }
+        }
+
+        if (deferred != nullptr && deferred->count > 0) {
+            shard->deferred.emplace_back([deferred]() {
+                for (size_t i = 0; i < deferred->count; ++i) {
+                    const Row& row = deferred->rows[i];
+                    T* component = deferred->ecs->TryGet<T>(row.entity);
+                    if (component == nullptr) continue;
+                    for (int column = 0; column < LuaColumns<T>::count; ++column) {
+                        LuaColumns<T>::Get(*component, column) = row.values[column];
+                    }
+                }
+                });
+        }
+        return 0;
+    }
+
+    /*
+        ECS.Get<Name>(entity) -> component or nil
+        Normally a pointer into the ECS. While the shard runs in parallel with others it is a copy instead:
+        writing through a pointer would race with the other states reading the same component. The copy is
+        written back after the tick, before the shard's queued writes, and only the fields the script changed.
+    */
+    template<typename T>
+    int ScriptManager::LuaGetComponent(lua_State* L)
+    {
+        Shard* shard = static_cast<Shard*>(lua_touserdata(L, lua_upvalueindex(1)));
+        const entityID entity = entityID(luaL_checkinteger(L, 1));
+        T* component = shard->owner->engine->ecs.TryGet<T>(entity);
+        if (component == nullptr) {
+            lua_pushnil(L);
+            return 1;
+        }
+        if (!shard->deferWrites) {
+            return sol::stack::push(L, component);
+        }
+
+        sol::stack::push<T>(L, *component);
+        const int originalRef = luaL_ref(L, LUA_REGISTRYINDEX);
+        sol::stack::push<T>(L, *component);
+        lua_pushvalue(L, -1);
+        const int copyRef = luaL_ref(L, LUA_REGISTRYINDEX);
+        shard->componentCopies.push_back(ComponentCopy{ entity, copyRef, originalRef, &ScriptManager::WriteBackComponent<T> });
+        return 1;
+    }
+
+    template<typename T>
+    void ScriptManager::WriteBackComponent(Shard& shard, const ComponentCopy& copy)
+    {
+        lua_State* L = shard.lua->lua_state();
+        lua_rawgeti(L, LUA_REGISTRYINDEX, copy.copyRef);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, copy.originalRef);
+        T& changed = sol::stack::unqualified_get<T&>(L, -2);
+        T& original = sol::stack::unqualified_get<T&>(L, -1);
+
+        // Entities that lost T during the tick are skipped.
+        if (T* component = shard.owner->engine->ecs.TryGet<T>(copy.entity)) {
+            if constexpr (LuaColumns<T>::count > 0) {
+                // Column by column, so two states changing different fields of one component both land.
+                for (int column = 0; column < LuaColumns<T>::count; ++column) {
+                    if (LuaColumns<T>::Get(changed, column) != LuaColumns<T>::Get(original, column)) {
+                        LuaColumns<T>::Get(*component, column) = LuaColumns<T>::Get(changed, column);
+                    }
+                }
+            }
+            else if (!(changed == original)) {
+                *component = changed;
+            }
+        }
+
+        lua_pop(L, 2);
+        luaL_unref(L, LUA_REGISTRYINDEX, copy.copyRef);
+        luaL_unref(L, LUA_REGISTRYINDEX, copy.originalRef);
+    }
+
+    template<typename T>
+    void ScriptManager::BindComponent(Shard& shard, sol::table& ecs_namespace)
+    {
+        const std::string name = ComponentName<T>;
+
+        SetClosure(ecs_namespace, ("Get" + name).c_str(), &ScriptManager::LuaGetComponent<T>, &shard);
+        // HasComponent - check if entity has a component
+        ecs_namespace["Has" + name] = [this](entityID entity) {
+            return engine->ecs.Has<T>(entity);
+        };
+        // RemoveComponent - remove a component from an entity
+        ecs_namespace["Remove" + name] = [this, &shard](entityID entity) {
+            RunOrDefer(shard, [this, entity]() {
+                engine->ecs.Drop<T>(entity);
+                if constexpr (std::is_same_v<T, Script>) {
+                    RemoveEntityScript(entity);
+                }
+                });
+        };
+
+        // Read<Name>/Write<Name>: the whole component column as flat Lua arrays.
+        if constexpr (LuaColumns<T>::count > 0) {
+            SetClosure(ecs_namespace, ("Read" + name).c_str(), &LuaReadColumns<T>, &engine->ecs);
+            SetClosure(ecs_namespace, ("Write" + name).c_str(), &ScriptManager::LuaWriteColumns<T>, &shard);
+        }
+    }
+
+    template<typename T>
+    void ScriptManager::RegisterComponentAdder(Shard& shard)
+    {
+        // Components come in as values (`Transform(...)`) or as pointers (`ECS.GetTransform(other)`, const or not),
+        // and sol2 gives each its own metatable. All of them store the T* first, so one getter handles them.
+        // The value is copied out right away, the Lua object may be gone by the time a deferred add runs.
+        auto add = [](Shard& shard, entityID entity, lua_State* L, int index) {
+            ScriptManager* self = shard.owner;
+            T component = sol::stack::unqualified_get<T&>(L, index);
+            self->RunOrDefer(shard, [self, entity, component = std::move(component)]() {
+                self->engine->ecs.Get<T>(entity) = component;
+                });
+        };
+
+        lua_State* L = shard.lua->lua_state();
+        for (const std::string* metatableName : { &sol::usertype_traits<T>::metatable(), &sol::usertype_traits<T*>::metatable(), &sol::usertype_traits<const T*>::metatable() }) {
+            luaL_getmetatable(L, metatableName->c_str());
+            if (lua_istable(L, -1)) {
+                shard.componentAdders.push_back(ComponentAdder{ lua_topointer(L, -1), add });
+            }
+            lua_pop(L, 1);
+        }
+    }
+
+    int ScriptManager::LuaAddComponent(lua_State* L)
+    {
+        Shard* shard = static_cast<Shard*>(lua_touserdata(L, lua_upvalueindex(1)));
+        const entityID entity = entityID(lua_tointeger(L, 1));
+
+        if (lua_getmetatable(L, 2)) {
+            const void* metatable = lua_topointer(L, -1);
+            lua_pop(L, 1);
+            for (const ComponentAdder& adder : shard->componentAdders) {
+                if (adder.metatable == metatable) {
+                    adder.add(*shard, entity, L, 2);
+                    return 0;
+                }
+            }
+        }
+        return luaL_error(L, "ECS.AddComponent: argument 2 is not a component");
+    }
+
     sol::protected_function* ScriptManager::GetScript(const std::string& name)
     {
         auto it = scripts.find(name);
@@ -347,48 +837,258 @@ namespace willengine
         return nullptr;
     }
 
-    void ScriptManager::InitializeEntityScript(entityID entity, const std::string& scriptName) {
-        // Create isolated environment for this script if not already created
-        if (scriptEnvironments.find(scriptName) == scriptEnvironments.end()) {
-            // Create environment that inherits from globals (so ECS, Input, etc. are accessible)
-            sol::environment env(lua, sol::create, lua.globals());
-            
-            // Load and run the script file INTO this isolated environment
-            std::string scriptPath = engine->resource->ResolvePath("scripts/" + scriptName + ".lua");
-            lua.script_file(scriptPath, env);
-            
-            scriptEnvironments[scriptName] = env;
-            spdlog::info("Loaded script '{}' into isolated environment", scriptName);
+    void ScriptManager::SetEntityGlobal(const std::string& name, entityID entity)
+    {
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            (*shard->lua)[name] = entity;
+        }
+    }
+
+    bool ScriptManager::RunChunk(sol::state& lua, const std::string& resolvedPath, const sol::environment* env, std::string& error)
+    {
+        const std::string* bytecode = engine->resource->GetLuaBytecode(resolvedPath);
+        if (!bytecode) {
+            error = "can't compile " + resolvedPath;
+            return false;
         }
 
+        sol::load_result chunk = lua.load(*bytecode, "@" + resolvedPath, sol::load_mode::binary);
+        if (!chunk.valid()) {
+            sol::error err = chunk;
+            error = err.what();
+            return false;
+        }
+        sol::protected_function function = chunk;
+        if (env) {
+            sol::set_environment(*env, function);
+        }
+
+        sol::protected_function_result result = function();
+        if (!result.valid()) {
+            sol::error err = result;
+            error = err.what();
+            return false;
+        }
+        return true;
+    }
+
+    uint32_t ScriptManager::GetOrLoadScriptType(Shard& shard, const std::string& scriptName)
+    {
+        auto it = shard.scriptTypeIndices.find(scriptName);
+        if (it != shard.scriptTypeIndices.end()) {
+            return it->second;
+        }
+
+        sol::state& lua = *shard.lua;
+        ScriptType type;
+        type.name = scriptName;
+        type.batch = lua.create_table();
+        // Create environment that inherits from globals (so ECS, Input, etc. are accessible)
+        type.env = sol::environment(lua, sol::create, lua.globals());
+
+        // Load and run the script file INTO this isolated environment
+        std::string scriptPath = engine->resource->ResolvePath("scripts/" + scriptName + ".lua");
+        std::string error;
+        if (!RunChunk(lua, scriptPath, &type.env, error)) {
+            spdlog::error("Failed to load script '{}': {}", scriptName, error);
+        }
+        ResolveScriptFunctions(type);
+
+        const uint32_t index = (uint32_t)shard.scriptTypes.size();
+        shard.scriptTypes.push_back(std::move(type));
+        shard.scriptTypeIndices[scriptName] = index;
+        spdlog::info("Loaded script '{}' into isolated environment", scriptName);
+        return index;
+    }
+
+    void ScriptManager::ResolveScriptFunctions(ScriptType& type)
+    {
+        // Looked up once here instead of env[name] on every call.
+        sol::optional<sol::protected_function> start = type.env["Start"];
+        sol::optional<sol::protected_function> update = type.env["Update"];
+        sol::optional<sol::protected_function> updateAll = type.env["UpdateAll"];
+        sol::optional<sol::protected_function> onCollision = type.env["OnCollision"];
+        sol::optional<sol::protected_function> onCollisionEnd = type.env["OnCollisionEnd"];
+        type.start = start ? *start : sol::protected_function();
+        type.update = update ? *update : sol::protected_function();
+        type.updateAll = updateAll ? *updateAll : sol::protected_function();
+        type.onCollision = onCollision ? *onCollision : sol::protected_function();
+        type.onCollisionEnd = onCollisionEnd ? *onCollisionEnd : sol::protected_function();
+    }
+
+    ScriptManager::Shard& ScriptManager::LeastLoadedShard()
+    {
+        Shard* least = shards[0].get();
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            if (shard->bindings.size() < least->bindings.size()) {
+                least = shard.get();
+            }
+        }
+        return *least;
+    }
+
+    void ScriptManager::InitializeEntityScript(entityID entity, const std::string& scriptName) {
+        // An entity keeps its shard for life, new entities go wherever there is the least work.
+        auto shardIt = entityShards.find(entity);
+        Shard& shard = shardIt != entityShards.end() ? *shards[shardIt->second] : LeastLoadedShard();
+        entityShards[entity] = shard.index;
+
+        const uint32_t type = GetOrLoadScriptType(shard, scriptName);
+
         // Create a unique table for this entity's script instance
-        sol::table instance = lua.create_table();
+        sol::table instance = shard.lua->create_table();
         instance["entity"] = entity;  // Script can access its own entity
 
         // Store the instance and remember which script this entity uses
-        scriptInstances[entity] = instance;
-        entityScriptNames[entity] = scriptName;
+        auto it = shard.bindingIndices.find(entity);
+        if (it != shard.bindingIndices.end()) {
+            RemoveFromBatch(shard, it->second);
+            shard.bindings[it->second].type = type;
+            shard.bindings[it->second].instance = instance;
+            shard.bindings[it->second].removed = false;
+            AddToBatch(shard, it->second);
+            return;
+        }
+        shard.bindingIndices[entity] = shard.bindings.size();
+        shard.bindings.push_back(ScriptBinding{ entity, type, instance, 0 });
+        AddToBatch(shard, shard.bindings.size() - 1);
     }
 
-    void ScriptManager::CallEntityFunction(entityID entity, const std::string& functionName) {
-        auto instanceIt = scriptInstances.find(entity);
-        if (instanceIt == scriptInstances.end()) return;
+    void ScriptManager::AddToBatch(Shard& shard, size_t bindingIndex)
+    {
+        ScriptBinding& binding = shard.bindings[bindingIndex];
+        ScriptType& type = shard.scriptTypes[binding.type];
+        binding.batchIndex = type.batchBindings.size();
+        type.batchBindings.push_back(bindingIndex);
+        type.batch[binding.batchIndex + 1] = binding.instance;
+    }
+
+    void ScriptManager::RemoveFromBatch(Shard& shard, size_t bindingIndex)
+    {
+        // Swap-remove, so the Lua array stays a proper sequence without holes.
+        ScriptBinding& binding = shard.bindings[bindingIndex];
+        ScriptType& type = shard.scriptTypes[binding.type];
+        const size_t last = type.batchBindings.size() - 1;
+        if (binding.batchIndex != last) {
+            const size_t moved = type.batchBindings[last];
+            type.batchBindings[binding.batchIndex] = moved;
+            shard.bindings[moved].batchIndex = binding.batchIndex;
+            type.batch[binding.batchIndex + 1] = shard.bindings[moved].instance;
+        }
+        type.batchBindings.pop_back();
+        type.batch[last + 1] = sol::lua_nil;
+    }
+
+    void ScriptManager::MoveBinding(Shard& shard, size_t from, size_t to)
+    {
+        shard.bindings[to] = std::move(shard.bindings[from]);
+        shard.bindingIndices[shard.bindings[to].entity] = to;
+        shard.scriptTypes[shard.bindings[to].type].batchBindings[shard.bindings[to].batchIndex] = to;
+    }
+
+    void ScriptManager::RemoveEntityScript(entityID entity)
+    {
+        auto shardIt = entityShards.find(entity);
+        if (shardIt == entityShards.end()) return;
+
+        Shard& shard = *shards[shardIt->second];
+        RemoveBinding(shard, entity);
+        if (!shard.dispatching) {
+            entityShards.erase(shardIt);
+        }
+    }
+
+    void ScriptManager::RemoveBinding(Shard& shard, entityID entity)
+    {
+        auto it = shard.bindingIndices.find(entity);
+        if (it == shard.bindingIndices.end()) return;
+
+        // Don't reshuffle the array under the Update loop, it's compacted once the loop is done.
+        if (shard.dispatching) {
+            shard.bindings[it->second].removed = true;
+            shard.pendingRemovals = true;
+            return;
+        }
+
+        const size_t index = it->second;
+        RemoveFromBatch(shard, index);
+        shard.bindingIndices.erase(it);
+        if (index != shard.bindings.size() - 1) {
+            MoveBinding(shard, shard.bindings.size() - 1, index);
+        }
+        shard.bindings.pop_back();
+    }
+
+    void ScriptManager::CompactBindings(Shard& shard)
+    {
+        if (!shard.pendingRemovals) return;
+        shard.pendingRemovals = false;
+
+        size_t kept = 0;
+        for (size_t i = 0; i < shard.bindings.size(); ++i) {
+            if (shard.bindings[i].removed) {
+                RemoveFromBatch(shard, i);
+                shard.bindingIndices.erase(shard.bindings[i].entity);
+                // Re-bound while the removal was pending? Then it is already live again elsewhere.
+                auto shardIt = entityShards.find(shard.bindings[i].entity);
+                if (shardIt != entityShards.end() && shardIt->second == shard.index) {
+                    entityShards.erase(shardIt);
+                }
+                continue;
+            }
+            if (kept != i) {
+                MoveBinding(shard, i, kept);
+            }
+            kept++;
+        }
+        shard.bindings.resize(kept);
+    }
+
+    bool ScriptManager::ReloadScript(const std::string& scriptName)
+    {
+        // Every state that has loaded the script gets the new code.
+        // Per-entity state lives in the binding instance tables and is untouched.
+        std::string scriptPath = engine->resource->ResolvePath("scripts/" + scriptName + ".lua");
+        bool reloaded = true;
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            auto typeIt = shard->scriptTypeIndices.find(scriptName);
+            if (typeIt == shard->scriptTypeIndices.end()) {
+                // No entity in this state uses the script yet, it will be loaded on first use.
+                continue;
+            }
+            ScriptType& type = shard->scriptTypes[typeIt->second];
+
+            std::string error;
+            if (!RunChunk(*shard->lua, scriptPath, &type.env, error)) {
+                spdlog::error("Failed to reload script '{}': {}", scriptName, error);
+                reloaded = false;
+                continue;
+            }
+            ResolveScriptFunctions(type);
+        }
+
+        if (reloaded) {
+            spdlog::info("Reloaded script '{}'", scriptName);
+        }
+        return reloaded;
+    }
 
-        auto scriptNameIt = entityScriptNames.find(entity);
-        if (scriptNameIt == entityScriptNames.end()) return;
+    void ScriptManager::CallEntityFunction(entityID entity, const std::string& functionName) {
+        auto shardIt = entityShards.find(entity);
+        if (shardIt == entityShards.end()) return;
+        Shard& shard = *shards[shardIt->second];
 
-        sol::table& instance = instanceIt->second;
-        const std::string& scriptName = scriptNameIt->second;
+        auto bindingIt = shard.bindingIndices.find(entity);
+        if (bindingIt == shard.bindingIndices.end()) return;
 
-        // Get the environment for this script
-        auto envIt = scriptEnvironments.find(scriptName);
-        if (envIt == scriptEnvironments.end()) return;
+        ScriptBinding& binding = shard.bindings[bindingIt->second];
+        if (binding.removed) return;
 
         // Get the function from this script's isolated environment (not global!)
-        sol::environment& env = envIt->second;
+        sol::environment& env = shard.scriptTypes[binding.type].env;
         sol::optional<sol::protected_function> func = env[functionName];
         if (func) {
-            sol::protected_function_result result = (*func)(instance);
+            sol::protected_function_result result = (*func)(binding.instance);
             if (!result.valid()) {
                 sol::error err = result;
                 spdlog::error("Error in {} for entity {}: {}", functionName, entity, err.what());
@@ -396,15 +1096,357 @@ namespace willengine
         }
     }
 
+    template<typename... Args>
+    void ScriptManager::CallProfiled(Shard& shard, ScriptType& type, ScriptFunction which, const sol::protected_function& func, entityID entity, Args&&... args)
+    {
+        using clock = std::chrono::steady_clock;
+        const bool profile = profiling;
+        const clock::time_point start = profile ? clock::now() : clock::time_point();
+        const size_t bytesBefore = shard.allocatedBytes;
+
+        sol::protected_function_result result = func(std::forward<Args>(args)...);
+
+        if (profile) {
+            FunctionStats& stats = type.stats[which];
+            stats.calls++;
+            stats.milliseconds += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            stats.bytesAllocated += shard.allocatedBytes - bytesBefore;
+        }
+        if (!result.valid()) {
+            sol::error err = result;
+            if (which == kUpdateAll) {
+                spdlog::error("Error in UpdateAll for script '{}': {}", type.name, err.what());
+            }
+            else {
+                spdlog::error("Error in {} for entity {}: {}", kScriptFunctionNames[which], entity, err.what());
+            }
+        }
+    }
+
+    void ScriptManager::CallBindings(Shard& shard, sol::protected_function ScriptType::* function, ScriptFunction which)
+    {
+        shard.dispatching = true;
+        // Scripts may add bindings while we run, only visit the ones that existed when we started.
+        const size_t count = shard.bindings.size();
+        for (size_t i = 0; i < count; ++i) {
+            ScriptBinding& binding = shard.bindings[i];
+            if (binding.removed) continue;
+
+            ScriptType& type = shard.scriptTypes[binding.type];
+            if (which == kUpdate && type.updateAll.valid()) continue;	// handled by UpdateAll
+
+            const sol::protected_function& func = type.*function;
+            if (!func.valid()) continue;
+
+            // The instance is pushed before the call runs, so `bindings` growing during it is fine.
+            CallProfiled(shard, type, which, func, binding.entity, binding.instance);
+        }
+        shard.dispatching = false;
+        // While shards run in parallel, entityShards is shared: compact once everyone is done.
+        if (!shard.deferWrites) {
+            CompactBindings(shard);
+        }
+    }
+
+    void ScriptManager::UpdateShard(Shard& shard)
+    {
+        WILLENGINE_TRACE_ZONE("Scripts::UpdateShard");
+        // Batched scripts: one call per script type. Entities removed during the tick
+        // stay in the array until the tick is over, same as in the per-entity loop.
+        shard.dispatching = true;
+        for (size_t i = 0; i < shard.scriptTypes.size(); ++i) {
+            ScriptType& type = shard.scriptTypes[i];
+            if (!type.updateAll.valid() || type.batchBindings.empty()) continue;
+
+            CallProfiled(shard, type, kUpdateAll, type.updateAll, entityID(0), type.batch);
+        }
+        shard.dispatching = false;
+
+        CallBindings(shard, &ScriptType::update, kUpdate);
+    }
+
+    void ScriptManager::WorkerLoop(uint32_t shardIndex)
+    {
+        WILLENGINE_TRACE_THREAD("Lua worker");
+        Shard& shard = *shards[shardIndex];
+        uint32_t seen = workGeneration.load();
+        while (true) {
+            workGeneration.wait(seen);
+            const uint32_t generation = workGeneration.load();
+            if (generation == seen) continue;
+            seen = generation;
+            if (!workersRunning) return;
+
+            UpdateShard(shard);
+            if (workPending.fetch_sub(1) == 1) {
+                workPending.notify_one();
+            }
+        }
+    }
+
     void ScriptManager::UpdateAllEntityScripts() {
-        engine->ecs.ForEach<Script>([this](entityID entity) {
-            CallEntityFunction(entity, "Update");
-            });
+        WILLENGINE_TRACE_ZONE("Scripts::UpdateAllEntityScripts");
+        if (shards.size() == 1) {
+            UpdateShard(*shards[0]);
+            return;
+        }
+
+        // Every shard runs at once: shard 0 here, the rest on their workers. Reads see the state
+        // from before the tick, writes are queued and replayed below in shard order.
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            shard->deferWrites = true;
+        }
+        workPending = uint32_t(shards.size() - 1);
+        workGeneration.fetch_add(1);
+        workGeneration.notify_all();
+
+        UpdateShard(*shards[0]);
+
+        {
+            WILLENGINE_TRACE_ZONE("Scripts::WaitForWorkers");
+            for (uint32_t pending = workPending.load(); pending != 0; pending = workPending.load()) {
+                workPending.wait(pending);
+            }
+        }
+
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            shard->deferWrites = false;
+        }
+        WILLENGINE_TRACE_ZONE("Scripts::ReplayDeferredWrites");
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            for (const ComponentCopy& copy : shard->componentCopies) {
+                copy.writeBack(*shard, copy);
+            }
+            shard->componentCopies.clear();
+            std::vector<std::function<void()>> writes = std::move(shard->deferred);
+            shard->deferred.clear();
+            for (const std::function<void()>& write : writes) {
+                write();
+            }
+            shard->deferredArena.EndFrame();
+        }
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            CompactBindings(*shard);
+        }
     }
 
     void ScriptManager::StartAllEntityScripts() {
-        engine->ecs.ForEach<Script>([this](entityID entity) {
-            CallEntityFunction(entity, "Start");
+        // Start runs once, before the loop: one shard after the other, writes go through immediately.
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            CallBindings(*shard, &ScriptType::start, kStart);
+        }
+    }
+
+    void ScriptManager::DispatchCollisions() {
+        // Straight from the physics contact buffers: no event objects, the only per-contact work is
+        // two binding lookups and the Lua calls themselves. Runs on the main thread between ticks,
+        // so writes go through immediately, same as Start.
+        const std::vector<Contact>& begun = engine->physics->GetContacts(ContactPhase::Begin);
+        const std::vector<Contact>& ended = engine->physics->GetContacts(ContactPhase::End);
+        if (begun.empty() && ended.empty()) return;
+        WILLENGINE_TRACE_ZONE("Scripts::DispatchCollisions");
+
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            shard->dispatching = true;
+        }
+        for (const Contact& contact : begun) {
+            CallCollisionHandler(&ScriptType::onCollision, kOnCollision, contact.a, contact.b);
+            CallCollisionHandler(&ScriptType::onCollision, kOnCollision, contact.b, contact.a);
+        }
+        for (const Contact& contact : ended) {
+            CallCollisionHandler(&ScriptType::onCollisionEnd, kOnCollisionEnd, contact.a, contact.b);
+            CallCollisionHandler(&ScriptType::onCollisionEnd, kOnCollisionEnd, contact.b, contact.a);
+        }
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            shard->dispatching = false;
+            CompactBindings(*shard);
+        }
+    }
+
+    void ScriptManager::CallCollisionHandler(sol::protected_function ScriptType::* function, ScriptFunction which, entityID self, entityID other)
+    {
+        auto shardIt = entityShards.find(self);
+        if (shardIt == entityShards.end()) return;
+        Shard& shard = *shards[shardIt->second];
+
+        auto bindingIt = shard.bindingIndices.find(self);
+        if (bindingIt == shard.bindingIndices.end()) return;
+        ScriptBinding& binding = shard.bindings[bindingIt->second];
+        if (binding.removed) return;	// destroyed by an earlier handler this step
+
+        ScriptType& type = shard.scriptTypes[binding.type];
+        const sol::protected_function& func = type.*function;
+        if (!func.valid()) return;
+
+        CallProfiled(shard, type, which, func, self, binding.instance, other);
+    }
+
+    void* ScriptManager::CountingAlloc(void* userdata, void* ptr, size_t oldSize, size_t newSize)
+    {
+        Shard* shard = static_cast<Shard*>(userdata);
+        // With ptr == nullptr, oldSize is a type tag rather than a size.
+        const size_t previous = ptr ? oldSize : 0;
+        if (newSize > previous) {
+            shard->allocatedBytes += newSize - previous;
+        }
+        return shard->baseAlloc(shard->baseAllocData, ptr, oldSize, newSize);
+    }
+
+    void ScriptManager::LineSampleHook(lua_State* L, lua_Debug* ar)
+    {
+        lua_pushlightuserdata(L, const_cast<char*>(&kProfilerRegistryKey));
+        lua_rawget(L, LUA_REGISTRYINDEX);
+        Shard* shard = static_cast<Shard*>(lua_touserdata(L, -1));
+        lua_pop(L, 1);
+
+        if (shard && lua_getinfo(L, "Sl", ar) && ar->currentline > 0) {
+            shard->lineSamples[std::string(ar->short_src) + ":" + std::to_string(ar->currentline)]++;
+        }
+    }
+
+    void ScriptManager::SetLineSampling(bool enabled, int instructionInterval)
+    {
+        lineSampling = enabled;
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            if (enabled) {
+                shard->lineSamples.clear();
+                lua_sethook(shard->lua->lua_state(), &ScriptManager::LineSampleHook, LUA_MASKCOUNT, std::max(instructionInterval, 1));
+            }
+            else {
+                lua_sethook(shard->lua->lua_state(), nullptr, 0, 0);
+            }
+        }
+    }
+
+    std::vector<ScriptLineSample> ScriptManager::GetLineSamples(size_t maxCount) const
+    {
+        // The same line runs in every state, so add the shards' counts together.
+        std::unordered_map<std::string, uint32_t> merged;
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            for (const auto& [location, count] : shard->lineSamples) {
+                merged[location] += count;
+            }
+        }
+
+        std::vector<ScriptLineSample> samples;
+        samples.reserve(merged.size());
+        for (const auto& [location, count] : merged) {
+            samples.push_back(ScriptLineSample{ location, count });
+        }
+        std::sort(samples.begin(), samples.end(), [](const ScriptLineSample& a, const ScriptLineSample& b) {
+            return a.samples > b.samples;
+            });
+        if (samples.size() > maxCount) {
+            samples.resize(maxCount);
+        }
+        return samples;
+    }
+
+    void ScriptManager::ResetLineSamples()
+    {
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            shard->lineSamples.clear();
+        }
+    }
+
+    void ScriptManager::StepGarbageCollector()
+    {
+        WILLENGINE_TRACE_ZONE("Scripts::StepGarbageCollector");
+        auto heapKB = [](lua_State* L) { return size_t(lua_gc(L, LUA_GCCOUNT, 0)); };
+
+        size_t totalHeapKB = 0;
+        if (gcBudgetMs <= 0.0) {
+            for (const std::unique_ptr<Shard>& shard : shards) {
+                totalHeapKB += heapKB(shard->lua->lua_state());
+            }
+            gcStats.heapKB = totalHeapKB;
+            return;
+        }
+
+        // The budget is for all states together, each gets an equal share.
+        using clock = std::chrono::steady_clock;
+        const clock::time_point start = clock::now();
+        const double shardBudgetMs = gcBudgetMs / double(shards.size());
+
+        uint32_t steps = 0;
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            lua_State* L = shard->lua->lua_state();
+            const clock::time_point shardStart = clock::now();
+            const clock::time_point deadline = shardStart + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::milli>(shardBudgetMs));
+
+            // If the heap outgrows what the budget can keep up with, finish the cycle anyway
+            // rather than let memory run away. 4 MB floor so small heaps never trigger it.
+            const bool runaway = heapKB(L) > std::max<size_t>(shard->heapAfterCycleKB * 4, 4096);
+
+            // A generational step is a whole minor (or major) collection and never reports the end of a cycle,
+            // so looping on it would collect until the budget runs out, or forever once the heap runs away.
+            // It only counts as a step: the heap after a minor collection still holds the old garbage, so
+            // only a full collection completes a cycle and moves the runaway baseline.
+            if (gcGenerational) {
+                if (runaway) {
+                    lua_gc(L, LUA_GCCOLLECT, 0);
+                    gcStats.cyclesCompleted++;
+                    gcStats.forcedCycles++;
+                    shard->heapAfterCycleKB = heapKB(L);
+                }
+                else {
+                    luacompat::StepGC(L, gcStepKB, true);
+                }
+                steps++;
+                totalHeapKB += heapKB(L);
+                continue;
+            }
+
+            bool finished = false;
+            do {
+                finished = luacompat::StepGC(L, gcStepKB, true);
+                steps++;
+            } while (!finished && (runaway || clock::now() < deadline));
+
+            if (finished) {
+                gcStats.cyclesCompleted++;
+                shard->heapAfterCycleKB = heapKB(L);
+                if (runaway) gcStats.forcedCycles++;
+            }
+            totalHeapKB += heapKB(L);
+        }
+        gcStats.heapKB = totalHeapKB;
+        gcStats.stepsLastFrame = steps;
+        gcStats.lastFrameMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        gcStats.maxFrameMs = std::max(gcStats.maxFrameMs, gcStats.lastFrameMs);
+    }
+
+    void ScriptManager::EndProfileFrame()
+    {
+        if (!profiling) {
+            frameProfile.clear();
+            return;
+        }
+
+        // A script loaded in several states shows up once, with the states' numbers added up.
+        frameProfile.clear();
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            for (ScriptType& type : shard->scriptTypes) {
+                for (int which = 0; which < kScriptFunctionCount; ++which) {
+                    FunctionStats& stats = type.stats[which];
+                    if (stats.calls == 0) continue;
+
+                    auto entry = std::find_if(frameProfile.begin(), frameProfile.end(), [&](const ScriptProfileEntry& e) {
+                        return e.script == type.name && e.function == kScriptFunctionNames[which];
+                        });
+                    if (entry == frameProfile.end()) {
+                        frameProfile.push_back(ScriptProfileEntry{ type.name, kScriptFunctionNames[which], 0, 0.0, 0 });
+                        entry = frameProfile.end() - 1;
+                    }
+                    entry->calls += stats.calls;
+                    entry->milliseconds += stats.milliseconds;
+                    entry->bytesAllocated += stats.bytesAllocated;
+                    stats = FunctionStats();
+                }
+            }
+        }
+        std::sort(frameProfile.begin(), frameProfile.end(), [](const ScriptProfileEntry& a, const ScriptProfileEntry& b) {
+            return a.milliseconds > b.milliseconds;
             });
     }
 
@@ -544,10 +1586,29 @@ namespace willengine
 
     void ScriptManager::Shutdown()
     {
-        // Clear all script-related data
-        scriptInstances.clear();
-        entityScriptNames.clear();
-        scriptEnvironments.clear();
+        // Workers first, nothing may touch a Lua state while it closes.
+        if (!workers.empty()) {
+            workersRunning = false;
+            workGeneration.fetch_add(1);
+            workGeneration.notify_all();
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+            workers.clear();
+        }
+
+        // Lua may still run __gc code while it closes, after our profiling state is gone.
+        SetLineSampling(false);
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            if (shard->baseAlloc) {
+                lua_setallocf(shard->lua->lua_state(), shard->baseAlloc, shard->baseAllocData);
+                shard->baseAlloc = nullptr;
+            }
+        }
+
+        // Clear all script-related data. The extra states close with their shards.
+        shards.clear();
+        entityShards.clear();
         scripts.clear();
     }
 }
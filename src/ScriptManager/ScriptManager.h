@@ -1,8 +1,16 @@
 #pragma once
-#define SOL_ALL_SAFETIES_ON 1
-#include <sol/sol.hpp>
+#include "SolConfig.h"
+#include "ScriptProfile.h"
 #include <unordered_map>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
 #include "../ECS/ECS.h"
+#include "../Engine.h"
+#include "../Simulation/Random.h"
 namespace willengine
 {
 	class Engine;
@@ -14,19 +22,35 @@ namespace willengine
 		ScriptManager(Engine* engine);
 		~ScriptManager() = default;
 
-		void Startup();
+		void Startup(Engine::Config& config);
 		void Shutdown();
 
+		// Number of Lua states entity scripts are spread across (Config::script_threads).
+		size_t GetShardCount() const { return shards.size(); }
+
 		sol::protected_function* GetScript(const std::string& name);
 
+		// Names an entity for scripts (`player`), in every Lua state.
+		void SetEntityGlobal(const std::string& name, entityID entity);
+
 		void InitializeEntityScript(entityID entity, const std::string& scriptName);
 
+		// Unbinds an entity from its script (when the Script component or the entity goes away).
+		void RemoveEntityScript(entityID entity);
+
+		// Re-runs a changed script into its existing environment. Entity instance tables are kept.
+		bool ReloadScript(const std::string& scriptName);
+
 		void CallEntityFunction(entityID entity, const std::string& functionName);
 
 		void UpdateAllEntityScripts();
 
 		void StartAllEntityScripts();
 
+		// Calls OnCollision(self, other) for contacts that began in the last physics step and
+		// OnCollisionEnd(self, other) for those that ended, on both entities' scripts.
+		void DispatchCollisions();
+
 		bool RunScript(const std::string& name);
 
 		bool CallFunction(const std::string& scriptName, const std::string& functionName);
@@ -40,17 +64,183 @@ namespace willengine
 
 		const std::unordered_map<std::string, sol::protected_function>& BringScripts() const;
 
+		// Profiling: per (script, function) wall time and Lua bytes allocated, aggregated per frame.
+		void SetProfilingEnabled(bool enabled) { profiling = enabled; }
+		bool IsProfilingEnabled() const { return profiling; }
+		// Closes the current frame: its totals become GetFrameProfile() and counting starts over.
+		void EndProfileFrame();
+		const std::vector<ScriptProfileEntry>& GetFrameProfile() const { return frameProfile; }
+
+		// Line sampling: every `instructionInterval` Lua instructions, note which source line is running.
+		void SetLineSampling(bool enabled, int instructionInterval = 1000);
+		bool IsLineSampling() const { return lineSampling; }
+		// Most sampled lines first, since sampling was (re)started.
+		std::vector<ScriptLineSample> GetLineSamples(size_t maxCount = 20) const;
+		void ResetLineSamples();
+
+		// Runs the Lua GC for up to the configured per-frame budget. Called by the engine after drawing,
+		// so collection work lands in idle time instead of inside UpdateAllEntityScripts.
+		void StepGarbageCollector();
+		const ScriptGCStats& GetGCStats() const { return gcStats; }
+
 	private:
-		sol::state lua;
+		sol::state lua;		// the main Lua state, shard 0
 		Engine* engine;
 
+		// The script functions the engine calls itself, and profiles.
+		enum ScriptFunction { kStart, kUpdate, kUpdateAll, kOnCollision, kOnCollisionEnd, kScriptFunctionCount };
+
+		struct FunctionStats
+		{
+			uint32_t calls = 0;
+			double milliseconds = 0.0;
+			size_t bytesAllocated = 0;
+		};
+
+		// One per script file. Script isolation: each script gets its own environment,
+		// and its Start/Update functions are resolved once instead of looked up by name per call.
+		struct ScriptType
+		{
+			std::string name;
+			sol::environment env;
+			sol::protected_function start;
+			sol::protected_function update;
+			// Opt-in batched mode: if the script defines UpdateAll(instances) it is called once per tick
+			// with every instance of this script in `batch` (a Lua array), and Update is not called per entity.
+			sol::protected_function updateAll;
+			sol::protected_function onCollision;
+			sol::protected_function onCollisionEnd;
+			sol::table batch;
+			std::vector<size_t> batchBindings;	// batch[i + 1] belongs to bindings[batchBindings[i]]
+			FunctionStats stats[kScriptFunctionCount];	// this frame, while profiling
+		};
+
+		// One per scripted entity, kept densely packed so the Update loop just walks the array.
+		struct ScriptBinding
+		{
+			entityID entity;
+			uint32_t type;			// index into scriptTypes
+			sol::table instance;	// the script's `self`
+			size_t batchIndex;		// index into the type's batch array
+			bool removed = false;	// removed while dispatching, compacted afterwards
+		};
+
+		struct Shard;
+
+		// ECS.AddComponent dispatch table: metatable of the component userdata -> typed setter.
+		struct ComponentAdder
+		{
+			const void* metatable;
+			void (*add)(Shard& shard, entityID entity, lua_State* L, int index);
+		};
+
+		// A component ECS.Get<Name> handed out as a copy because the shard was running in parallel.
+		struct ComponentCopy
+		{
+			entityID entity;
+			int copyRef;		// registry references: the copy the script got, and the value it started from
+			int originalRef;
+			void (*writeBack)(Shard& shard, const ComponentCopy& copy);
+		};
+
+		// Everything that belongs to one Lua state. Shard 0 runs on the main state (`lua`). With
+		// Config::script_threads > 1 the other shards own their states and are updated on worker threads.
+		struct Shard
+		{
+			ScriptManager* owner = nullptr;
+			uint32_t index = 0;
+			std::unique_ptr<sol::state> ownedState;	// first, so it outlives the Lua references below
+			sol::state* lua = nullptr;
+
+			std::deque<ScriptType> scriptTypes;	// deque: loading a new type mid-Update must not move the others
+			std::unordered_map<std::string, uint32_t> scriptTypeIndices;
+			std::vector<ScriptBinding> bindings;
+			std::unordered_map<entityID, size_t> bindingIndices;	// entity -> index in bindings
+			bool dispatching = false;
+			bool pendingRemovals = false;
+			std::vector<ComponentAdder> componentAdders;
+			Random random;	// the Random namespace
+
+			// While shards run in parallel, every write to shared engine state (structural ECS changes,
+			// sounds, loading) is queued here and replayed on the main thread once all shards are done.
+			bool deferWrites = false;
+			std::vector<std::function<void()>> deferred;
+			std::vector<ComponentCopy> componentCopies;	// written back before `deferred` is replayed
+			FrameArena deferredArena{ 64 * 1024 };		// data the queued writes carry, emptied after each replay
+
+			// Profiling. Every Lua allocation goes through CountingAlloc, which keeps allocatedBytes current.
+			lua_Alloc baseAlloc = nullptr;
+			void* baseAllocData = nullptr;
+			size_t allocatedBytes = 0;
+			std::unordered_map<std::string, uint32_t> lineSamples;
+			size_t heapAfterCycleKB = 0;	// after the last full cycle: the baseline a runaway heap is measured against
+		};
+
+		void InitializeShard(Shard& shard, Engine::Config& config);
+		void BindEngineAPI(Shard& shard);
+		Shard& LeastLoadedShard();
+		template<typename F>
+		void RunOrDefer(Shard& shard, F&& write);
+
+		// Runs a Lua file in `lua`, inside `env` if given. Loads the bytecode the ResourceManager compiled,
+		// so a file isn't parsed again for every environment and every shard.
+		bool RunChunk(sol::state& lua, const std::string& resolvedPath, const sol::environment* env, std::string& error);
+		uint32_t GetOrLoadScriptType(Shard& shard, const std::string& scriptName);
+		void ResolveScriptFunctions(ScriptType& type);
+		void UpdateShard(Shard& shard);
+		void CallBindings(Shard& shard, sol::protected_function ScriptType::* function, ScriptFunction which);
+		template<typename... Args>
+		void CallProfiled(Shard& shard, ScriptType& type, ScriptFunction which, const sol::protected_function& func, entityID entity, Args&&... args);
+		void CallCollisionHandler(sol::protected_function ScriptType::* function, ScriptFunction which, entityID self, entityID other);
+		void RemoveBinding(Shard& shard, entityID entity);
+		void CompactBindings(Shard& shard);
+		void AddToBatch(Shard& shard, size_t bindingIndex);
+		void RemoveFromBatch(Shard& shard, size_t bindingIndex);
+		void MoveBinding(Shard& shard, size_t from, size_t to);
+
+		// ECS.Get<Name>/Has<Name>/Remove<Name>/Read<Name>/Write<Name> for one component type.
+		template<typename T>
+		void BindComponent(Shard& shard, sol::table& ecs_namespace);
+		// Remembers T's userdata metatables so ECS.AddComponent can dispatch on them.
+		template<typename T>
+		void RegisterComponentAdder(Shard& shard);
+		static int LuaAddComponent(lua_State* L);
+		template<typename T>
+		static int LuaGetComponent(lua_State* L);
+		template<typename T>
+		static void WriteBackComponent(Shard& shard, const ComponentCopy& copy);
+		template<typename T>
+		static int LuaWriteColumns(lua_State* L);
+#if WILLENGINE_FAST_BINDINGS
+		void BindFastPaths(sol::table& input_namespace);
+#endif
+
+		static void* CountingAlloc(void* userdata, void* ptr, size_t oldSize, size_t newSize);
+		static void LineSampleHook(lua_State* L, lua_Debug* ar);
+
+		void WorkerLoop(uint32_t shardIndex);
+
 		std::unordered_map<std::string, sol::protected_function> scripts;
-		std::unordered_map<entityID, sol::table> scriptInstances;
-		
-		// Script isolation: each script gets its own environment
-		std::unordered_map<std::string, sol::environment> scriptEnvironments;
-		// Track which script name each entity uses
-		std::unordered_map<entityID, std::string> entityScriptNames;
+
+		std::vector<std::unique_ptr<Shard>> shards;
+		std::unordered_map<entityID, uint32_t> entityShards;	// entity -> shard its script runs in
+
+		// Worker threads, one per shard after the first. Each UpdateAllEntityScripts bumps
+		// workGeneration; workers update their shard and count workPending down to zero.
+		std::vector<std::thread> workers;
+		std::atomic<uint32_t> workGeneration{ 0 };
+		std::atomic<uint32_t> workPending{ 0 };
+		std::atomic<bool> workersRunning{ false };
+
+		bool profiling = false;
+		std::vector<ScriptProfileEntry> frameProfile;
+		bool lineSampling = false;
+
+		// Garbage collector
+		double gcBudgetMs = 0.0;	// 0: automatic collection
+		int gcStepKB = 32;
+		bool gcGenerational = false;	// Lua 5.4 generational mode: one step per frame, see StepGarbageCollector
+		ScriptGCStats gcStats;
 	};
 
 }
@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+namespace willengine
+{
+	// Time and Lua memory one script function took over the last frame, summed over every entity.
+	struct ScriptProfileEntry
+	{
+		std::string script;
+		std::string function;
+		uint32_t calls = 0;
+		double milliseconds = 0.0;
+		size_t bytesAllocated = 0;
+	};
+
+	// How many times the line sampler caught Lua running a given source line.
+	struct ScriptLineSample
+	{
+		std::string location;	// "source:line"
+		uint32_t samples = 0;
+	};
+
+	// Lua garbage collector numbers, see ScriptManager::StepGarbageCollector.
+	struct ScriptGCStats
+	{
+		size_t heapKB = 0;				// Lua heap right now
+		double lastFrameMs = 0.0;		// GC time spent after the last frame
+		double maxFrameMs = 0.0;		// worst of those since startup
+		uint32_t stepsLastFrame = 0;	// incremental steps, or minor collections in generational mode
+		uint32_t cyclesCompleted = 0;	// full cycles finished by the stepping; in generational mode only the forced ones
+		uint32_t forcedCycles = 0;		// cycles finished over budget because the heap ran away
+	};
+}
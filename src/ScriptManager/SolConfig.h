@@ -0,0 +1,20 @@
+#pragma once
+/*
+    sol2 configuration. Must be included before <sol/sol.hpp> everywhere it is used.
+
+    SOL_ALL_SAFETIES_ON adds argument type checks and stack checks to every bound call.
+    CMake defines it when WILLENGINE_SOL_SAFETIES is ON; otherwise it is only on in Debug builds
+    (no NDEBUG). Without safeties the hot bindings (Input.Key*, ECS.GetRigidbody, vec2 operators)
+    are registered as raw Lua C functions that skip sol2's checks and exception handling.
+*/
+#if !defined(SOL_ALL_SAFETIES_ON) && !defined(NDEBUG)
+#define SOL_ALL_SAFETIES_ON 1
+#endif
+
+#if defined(SOL_ALL_SAFETIES_ON) && SOL_ALL_SAFETIES_ON
+#define WILLENGINE_FAST_BINDINGS 0
+#else
+#define WILLENGINE_FAST_BINDINGS 1
+#endif
+
+#include <sol/sol.hpp>
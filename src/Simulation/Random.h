@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+namespace willengine
+{
+	/*
+		PCG32 (pcg-random.org). Small, fast, and unlike the std:: distributions its output is specified
+		bit for bit, so a seed gives the same sequence with every compiler and standard library.
+	*/
+	class Random
+	{
+	public:
+		explicit Random(uint64_t seed = 0, uint64_t stream = 0) { Seed(seed, stream); }
+
+		void Seed(uint64_t seed, uint64_t stream = 0)
+		{
+			state = 0;
+			increment = (stream << 1u) | 1u;
+			Next();
+			state += seed;
+			Next();
+		}
+
+		uint32_t Next()
+		{
+			const uint64_t old = state;
+			state = old * 6364136223846793005ULL + increment;
+			const uint32_t shifted = uint32_t(((old >> 18u) ^ old) >> 27u);
+			const uint32_t rotation = uint32_t(old >> 59u);
+			return (shifted >> rotation) | (shifted << ((32u - rotation) & 31u));
+		}
+
+		// Uniform in [0, 1), from the top 24 bits so every value is exactly representable.
+		float Float() { return float(Next() >> 8) * (1.0f / 16777216.0f); }
+
+		// Uniform in [lo, hi], both included. Rejection sampling, so no value is favoured (for ranges up to 2^32).
+		int64_t Int(int64_t lo, int64_t hi)
+		{
+			if (hi <= lo) return lo;
+			// Unsigned, so wide ranges don't overflow; the offset is added back modulo 2^64.
+			const uint64_t span = uint64_t(hi) - uint64_t(lo);
+			if (span >= 0xFFFFFFFFull) {
+				const uint64_t high = Next();	// two statements: the order of the draws must not be up to the compiler
+				const uint64_t value = (high << 32) | Next();
+				if (span == UINT64_MAX) return int64_t(value);
+				return int64_t(uint64_t(lo) + value % (span + 1));
+			}
+			const uint32_t bound = uint32_t(span + 1);
+			const uint32_t threshold = uint32_t(-bound) % bound;
+			uint32_t value = Next();
+			while (value < threshold) value = Next();
+			return int64_t(uint64_t(lo) + value % bound);
+		}
+
+	private:
+		uint64_t state = 0;
+		uint64_t increment = 1;
+	};
+}
@@ -0,0 +1,71 @@
+#include "StateHash.h"
+#include "../ECS/ECS.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace willengine
+{
+    namespace
+    {
+        struct Hasher
+        {
+            uint64_t value = 14695981039346656037ULL;
+
+            void Bytes(const void* data, size_t size)
+            {
+                const unsigned char* bytes = static_cast<const unsigned char*>(data);
+                for (size_t i = 0; i < size; ++i) {
+                    value ^= bytes[i];
+                    value *= 1099511628211ULL;
+                }
+            }
+            // Field by field rather than the whole struct, so padding never gets in.
+            void Add(int64_t v) { Bytes(&v, sizeof(v)); }
+            void Add(bool v) { Add(int64_t(v)); }
+            void Add(float v) { uint32_t bits; std::memcpy(&bits, &v, sizeof(bits)); Bytes(&bits, sizeof(bits)); }
+            void Add(double v) { uint64_t bits; std::memcpy(&bits, &v, sizeof(bits)); Bytes(&bits, sizeof(bits)); }
+            void Add(const vec2& v) { Add(v.x); Add(v.y); }
+            void Add(const std::string& s) { Add(int64_t(s.size())); Bytes(s.data(), s.size()); }
+        };
+
+        void HashComponent(Hasher& h, const Transform& t) { h.Add(vec2(t)); }
+        void HashComponent(Hasher& h, const Velocity& v) { h.Add(vec2(v)); }
+        void HashComponent(Hasher& h, const Rigidbody& rb) { h.Add(rb.position); h.Add(rb.velocity); }
+        void HashComponent(Hasher& h, const BoxCollider& c) { h.Add(c.dimensionSizes); h.Add(c.isCollided); }
+        void HashComponent(Hasher& h, const Sprite& s) { h.Add(s.image); h.Add(s.alpha); h.Add(s.scale); }
+        void HashComponent(Hasher& h, const Health& health) { h.Add(health.percent); }
+        void HashComponent(Hasher& h, const Gravity& g) { h.Add(g.meters_per_second); }
+        void HashComponent(Hasher& h, const Script& s) { h.Add(s.name); }
+
+        template<typename T>
+        void HashPool(Hasher& h, ECS& ecs, std::vector<std::pair<entityID, const void*>>& scratch)
+        {
+            // Sorted here whatever ECS::IsOrderedIteration says, the hash must not depend on it.
+            scratch.clear();
+            ecs.ForEachComponent<T>([&](entityID entity, T& component) { scratch.emplace_back(entity, &component); });
+            std::sort(scratch.begin(), scratch.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+            h.Bytes(ComponentName<T>, std::strlen(ComponentName<T>));
+            h.Add(int64_t(scratch.size()));
+            for (const auto& [entity, component] : scratch) {
+                h.Add(int64_t(entity));
+                HashComponent(h, *static_cast<const T*>(component));
+            }
+        }
+
+        template<typename... Ts>
+        void HashPools(Hasher& h, ECS& ecs, std::vector<std::pair<entityID, const void*>>& scratch, std::tuple<Ts...>*)
+        {
+            (HashPool<Ts>(h, ecs, scratch), ...);
+        }
+    }
+
+    uint64_t HashSimulationState(ECS& ecs)
+    {
+        Hasher h;
+        std::vector<std::pair<entityID, const void*>> scratch;
+        HashPools(h, ecs, scratch, static_cast<ComponentTypes*>(nullptr));
+        return h.value;
+    }
+}
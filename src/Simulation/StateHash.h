@@ -0,0 +1,11 @@
+#pragma once
+#include <Types.h>
+#include <cstdint>
+namespace willengine
+{
+	class ECS;
+
+	// 64-bit hash of every component of every entity (FNV-1a over the fields, entities in ID order).
+	// Two runs that agree on it at a tick agree on the whole simulation state at that tick.
+	uint64_t HashSimulationState(ECS& ecs);
+}
@@ -2,32 +2,282 @@
 #include "../Engine.h"
 #include "../ResourceManager/ResourceManager.h"
 #include "spdlog/spdlog.h"
+#include "../Tracing/Trace.h"
 
 namespace willengine
 {
-	SoundManager::SoundManager(Engine* engine) : engine(engine) {}
+	SoundManager::SoundManager(Engine* engine)
+		: engine(engine), playCounter(0), wakeCounter(0), serviceRunning(false), droppedCommands(0)
+	{
+	}
 	SoundManager::~SoundManager() {}
 
-	void SoundManager::Startup()
+	void SoundManager::Startup(bool headless)
 	{
-		soloud.init();
-		wav.createInstance();
+		soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, headless ? SoLoud::Soloud::NULLDRIVER : SoLoud::Soloud::AUTO);
+		soloud.setMaxActiveVoiceCount(kMaxVoices);
+
+		serviceRunning = true;
+		audioThread = std::thread(&SoundManager::AudioServiceLoop, this);
 	}
 
 	void SoundManager::Shutdown()
 	{
+		if (serviceRunning)
+		{
+			serviceRunning = false;
+			wakeCounter.fetch_add(1, std::memory_order_release);
+			wakeCounter.notify_one();
+			audioThread.join();
+		}
+		soloud.stopAll();
 		soloud.deinit();
 	}
 
+	soundID SoundManager::GetSoundID(const std::string& name) const
+	{
+		auto it = nameToSound.find(name);
+		return it != nameToSound.end() ? it->second : -1;
+	}
+
+	bool SoundManager::IsValid(soundID sound) const
+	{
+		return sound >= 0 && sound < (soundID)sounds.size() && sounds[sound].source != nullptr;
+	}
+
+	size_t SoundManager::GetSoundBytes() const
+	{
+		// Slots are only replaced on the simulation thread, which is the one asking.
+		size_t bytes = 0;
+		for (const SoundSlot& slot : sounds) {
+			if (!slot.source || slot.streamed) continue;
+			const SoLoud::Wav& wav = static_cast<const SoLoud::Wav&>(*slot.source);
+			bytes += size_t(wav.mSampleCount) * wav.mChannels * sizeof(float);
+		}
+		return bytes;
+	}
+
+	void SoundManager::Enqueue(AudioCommand::Type type, soundID sound, float value)
+	{
+		if (!IsValid(sound)) return;
+
+		if (!commands.Push(AudioCommand{ type, sound, value }))
+		{
+			droppedCommands.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		// notify_one only makes a syscall when the audio thread is actually asleep.
+		wakeCounter.fetch_add(1, std::memory_order_release);
+		wakeCounter.notify_one();
+	}
+
 	void SoundManager::PlaySound(const std::string& name)
 	{
-		if (nameToSoundMap.contains(name))
+		soundID sound = GetSoundID(name);
+		if (sound < 0)
+		{
+			spdlog::error("Sound not found: " + name);
+			return;
+		}
+		PlaySound(sound);
+	}
+
+	void SoundManager::PlaySound(soundID sound)
+	{
+		Enqueue(AudioCommand::Type::Play, sound);
+	}
+
+	void SoundManager::StopSound(const std::string& name)
+	{
+		StopSound(GetSoundID(name));
+	}
+
+	void SoundManager::StopSound(soundID sound)
+	{
+		Enqueue(AudioCommand::Type::Stop, sound);
+	}
+
+	void SoundManager::SetVolume(soundID sound, float volume)
+	{
+		Enqueue(AudioCommand::Type::SetVolume, sound, volume);
+	}
+
+	void SoundManager::SetPan(soundID sound, float pan)
+	{
+		Enqueue(AudioCommand::Type::SetPan, sound, pan);
+	}
+
+	void SoundManager::SetMaxInstances(soundID sound, int maxInstances)
+	{
+		Enqueue(AudioCommand::Type::SetMaxInstances, sound, (float)maxInstances);
+	}
+
+	void SoundManager::SetPriority(soundID sound, int priority)
+	{
+		Enqueue(AudioCommand::Type::SetPriority, sound, (float)priority);
+	}
+
+	void SoundManager::AudioServiceLoop()
+	{
+		WILLENGINE_TRACE_THREAD("Audio service");
+		uint32_t seen = wakeCounter.load(std::memory_order_acquire);
+		while (serviceRunning)
+		{
+			{
+				WILLENGINE_TRACE_ZONE("Sound::ExecuteCommands");
+				std::lock_guard<std::mutex> lock(slotMutex);
+				AudioCommand command;
+				while (commands.Pop(command))
+				{
+					Execute(command);
+				}
+			}
+
+			// Sleep until the simulation queues something new.
+			wakeCounter.wait(seen, std::memory_order_acquire);
+			seen = wakeCounter.load(std::memory_order_acquire);
+		}
+	}
+
+	void SoundManager::Execute(const AudioCommand& command)
+	{
+		// The slot may have been removed between queueing and now.
+		if (command.sound < 0 || command.sound >= (soundID)sounds.size() || !sounds[command.sound].source) return;
+		SoundSlot& slot = sounds[command.sound];
+
+		switch (command.type)
 		{
-			soloud.play(nameToSoundMap[name]);
+		case AudioCommand::Type::Play:
+			PlayNow(command.sound);
+			break;
+		case AudioCommand::Type::Stop:
+			StopNow(command.sound);
+			break;
+		case AudioCommand::Type::SetVolume:
+		case AudioCommand::Type::SetPan:
+			if (command.type == AudioCommand::Type::SetVolume) slot.volume = command.value;
+			else slot.pan = command.value;
+			for (Voice& voice : voices)
+			{
+				if (voice.sound != command.sound) continue;
+				if (command.type == AudioCommand::Type::SetVolume) soloud.setVolume(voice.handle, slot.volume);
+				else soloud.setPan(voice.handle, slot.pan);
+			}
+			break;
+		case AudioCommand::Type::SetMaxInstances:
+			slot.maxInstances = command.value < 1.0f ? 1 : (int)command.value;
+			break;
+		case AudioCommand::Type::SetPriority:
+			slot.priority = (int)command.value;
+			break;
+		}
+	}
+
+	void SoundManager::PlayNow(soundID sound)
+	{
+		SoundSlot& slot = sounds[sound];
+
+		// One pass over the pool: reclaim finished voices, count this sound's voices,
+		// and remember the candidates we may reuse.
+		int instances = 0;
+		Voice* oldestOfSound = nullptr;
+		Voice* freeVoice = nullptr;
+		Voice* weakest = nullptr;
+		for (Voice& voice : voices)
+		{
+			if (voice.sound >= 0 && !soloud.isValidVoiceHandle(voice.handle)) {
+				voice.sound = -1;
+			}
+			if (voice.sound < 0) {
+				if (!freeVoice) freeVoice = &voice;
+				continue;
+			}
+			if (voice.sound == sound) {
+				instances++;
+				if (!oldestOfSound || voice.startedAt < oldestOfSound->startedAt) oldestOfSound = &voice;
+			}
+			if (!weakest || voice.priority < weakest->priority ||
+				(voice.priority == weakest->priority && voice.startedAt < weakest->startedAt)) {
+				weakest = &voice;
+			}
+		}
+
+		Voice* target = nullptr;
+		if (instances >= slot.maxInstances && oldestOfSound) {
+			target = oldestOfSound;
+		}
+		else if (freeVoice) {
+			target = freeVoice;
+		}
+		else if (weakest && weakest->priority <= slot.priority) {
+			target = weakest;
+		}
+		else {
+			// Pool is full of more important sounds, drop this one.
+			return;
+		}
+
+		if (target->sound >= 0) {
+			soloud.stop(target->handle);
+		}
+		target->handle = soloud.play(*slot.source, slot.volume, slot.pan);
+		target->sound = sound;
+		target->priority = slot.priority;
+		target->startedAt = ++playCounter;
+	}
+
+	void SoundManager::StopNow(soundID sound)
+	{
+		soloud.stopAudioSource(*sounds[sound].source);
+		for (Voice& voice : voices)
+		{
+			if (voice.sound == sound) voice.sound = -1;
+		}
+	}
+
+	soundID SoundManager::InstallSound(const std::string& name, std::unique_ptr<SoLoud::AudioSource> source, bool streamed)
+	{
+		std::lock_guard<std::mutex> lock(slotMutex);
+
+		soundID sound = GetSoundID(name);
+		if (sound >= 0)
+		{
+			// Re-import: the mixer may still be reading the old samples. Keep the slot's settings.
+			if (sounds[sound].source) StopNow(sound);
 		}
 		else
 		{
-			spdlog::error("Sound not found: " + name);
+			if (!freeSlots.empty()) {
+				sound = freeSlots.back();
+				freeSlots.pop_back();
+			}
+			else {
+				sound = (soundID)sounds.size();
+				sounds.emplace_back();
+			}
+			sounds[sound] = SoundSlot{};
+			sounds[sound].name = name;
+			// A music track rarely wants to overlap with itself.
+			if (streamed) sounds[sound].maxInstances = 1;
+			nameToSound[name] = sound;
 		}
+
+		sounds[sound].source = std::move(source);
+		sounds[sound].streamed = streamed;
+		return sound;
+	}
+
+	bool SoundManager::RemoveSound(const std::string& name)
+	{
+		std::lock_guard<std::mutex> lock(slotMutex);
+
+		soundID sound = GetSoundID(name);
+		if (sound < 0) return false;
+
+		if (sounds[sound].source) StopNow(sound);
+		sounds[sound] = SoundSlot{};
+		freeSlots.push_back(sound);
+		nameToSound.erase(name);
+		return true;
 	}
-}
\ No newline at end of file
+}
@@ -1,8 +1,17 @@
 #pragma once
 #include <soloud.h>
 #include <soloud_wav.h>
+#include <soloud_wavstream.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
+#include "../Types.h"
+#include "../Containers/SpscRing.h"
 
 namespace willengine
 {
@@ -11,16 +20,101 @@ namespace willengine
 	{
 		friend class ResourceManager;
 	public:
+		// Size of the voice pool. When it's full, the lowest priority (then oldest) voice is stolen.
+		static constexpr int kMaxVoices = 32;
+		// Commands the simulation can queue before the audio thread catches up. Extra commands are dropped.
+		static constexpr size_t kCommandQueueSize = 1024;
+
 		SoundManager(Engine* engine);
 		~SoundManager();
-		void Startup();
+		// headless: SoLoud's null driver, sounds are tracked but nothing reaches an audio device.
+		void Startup(bool headless = false);
 		void Shutdown();
+
+		// Resolve a name once (e.g. in a script's Start) and play by ID afterwards.
+		soundID GetSoundID(const std::string& name) const;
+
+		/*
+			Playback calls only queue a command for the audio thread and return immediately,
+			they never wait on SoLoud's mixer lock. They must be called from the simulation thread.
+		*/
 		void PlaySound(const std::string& name);
+		void PlaySound(soundID sound);
+		void StopSound(const std::string& name);
+		void StopSound(soundID sound);
+		void SetVolume(soundID sound, float volume);
+		void SetPan(soundID sound, float pan);
+
+		// How many voices of this sound may play at once. Playing past the limit restarts the oldest one.
+		void SetMaxInstances(soundID sound, int maxInstances);
+		// Higher priority sounds steal voices from lower priority ones when the pool is full.
+		void SetPriority(soundID sound, int priority);
+
+		uint64_t GetDroppedCommandCount() const { return droppedCommands; }
+
+		size_t GetSoundCount() const { return nameToSound.size(); }
+		// Memory of the decoded samples. Streamed sounds only hold a small decode buffer and count as 0.
+		size_t GetSoundBytes() const;
+
 	private:
+		struct SoundSlot
+		{
+			std::string name;
+			std::unique_ptr<SoLoud::AudioSource> source;	// SoLoud::Wav, or SoLoud::WavStream for streamed tracks
+			bool streamed = false;
+			int maxInstances = 4;
+			int priority = 0;
+			float volume = 1.0f;
+			float pan = 0.0f;
+		};
+
+		struct Voice
+		{
+			SoLoud::handle handle = 0;
+			soundID sound = -1;		// -1 means the voice is free
+			int priority = 0;
+			uint64_t startedAt = 0;	// play counter value, smaller is older
+		};
+
+		struct AudioCommand
+		{
+			enum class Type : uint8_t { Play, Stop, SetVolume, SetPan, SetMaxInstances, SetPriority };
+			Type type;
+			soundID sound;
+			float value;
+		};
+
+		// Simulation thread side.
+		void Enqueue(AudioCommand::Type type, soundID sound, float value = 0.0f);
+		bool IsValid(soundID sound) const;
+
+		// Audio thread side.
+		void AudioServiceLoop();
+		void Execute(const AudioCommand& command);
+		void PlayNow(soundID sound);
+		void StopNow(soundID sound);
+
+		// Registers a decoded (or streamed) source under `name`, replacing and stopping any previous one.
+		// Loading happens on the simulation thread, so these take slotMutex to keep the audio thread out.
+		soundID InstallSound(const std::string& name, std::unique_ptr<SoLoud::AudioSource> source, bool streamed);
+		bool RemoveSound(const std::string& name);
+
 		Engine* engine;
 		SoLoud::Soloud soloud;
-		SoLoud::Wav wav;
 
-		std::unordered_map<std::string, SoLoud::Wav> nameToSoundMap;
+		std::vector<SoundSlot> sounds;
+		std::vector<soundID> freeSlots;
+		std::unordered_map<std::string, soundID> nameToSound;
+
+		// Owned by the audio thread.
+		std::array<Voice, kMaxVoices> voices;
+		uint64_t playCounter;
+
+		SpscRing<AudioCommand, kCommandQueueSize> commands;
+		std::atomic<uint32_t> wakeCounter;
+		std::atomic<bool> serviceRunning;
+		std::atomic<uint64_t> droppedCommands;
+		std::mutex slotMutex;
+		std::thread audioThread;
 	};
 }
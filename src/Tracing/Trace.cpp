@@ -0,0 +1,162 @@
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace willengine
+{
+    namespace trace
+    {
+        namespace
+        {
+            struct Event
+            {
+                const char* name;
+                uint64_t begin;
+                uint64_t end;
+            };
+
+            /*
+                Written by its own thread only. `head` counts every zone ever recorded; a reader copies
+                the slots, then re-reads `head` and drops whatever the writer may have overwritten meanwhile.
+            */
+            struct ThreadRing
+            {
+                uint32_t threadIndex = 0;
+                std::atomic<const char*> threadName{ nullptr };
+                std::atomic<uint64_t> head{ 0 };
+                std::atomic<uint64_t> clearedAt{ 0 };
+                Event events[kRingCapacity];
+            };
+
+            // Rings are registered once per thread (the only lock) and never freed, so a reader can
+            // still walk a ring whose thread has exited.
+            std::mutex registryMutex;
+            std::vector<std::unique_ptr<ThreadRing>>& Registry()
+            {
+                static std::vector<std::unique_ptr<ThreadRing>> rings;
+                return rings;
+            }
+
+            ThreadRing& LocalRing()
+            {
+                thread_local ThreadRing* ring = nullptr;
+                if (ring == nullptr) {
+                    std::lock_guard<std::mutex> lock(registryMutex);
+                    std::vector<std::unique_ptr<ThreadRing>>& rings = Registry();
+                    rings.push_back(std::make_unique<ThreadRing>());
+                    ring = rings.back().get();
+                    ring->threadIndex = uint32_t(rings.size());
+                }
+                return *ring;
+            }
+
+            const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+            void WriteEscaped(std::ofstream& out, const char* text)
+            {
+                for (const char* c = text; *c; ++c) {
+                    if (*c == '"' || *c == '\\') out << '\\';
+                    if (static_cast<unsigned char>(*c) >= 0x20) out << *c;
+                }
+            }
+        }
+
+        uint64_t Now()
+        {
+            return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+        }
+
+        void Record(const char* name, uint64_t begin, uint64_t end)
+        {
+            ThreadRing& ring = LocalRing();
+            const uint64_t head = ring.head.load(std::memory_order_relaxed);
+            ring.events[head & (kRingCapacity - 1)] = Event{ name, begin, end };
+            ring.head.store(head + 1, std::memory_order_release);
+        }
+
+        void SetThreadName(const char* name)
+        {
+            LocalRing().threadName.store(name, std::memory_order_relaxed);
+        }
+
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            for (const std::unique_ptr<ThreadRing>& ring : Registry()) {
+                ring->clearedAt.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+            }
+        }
+
+        bool WriteChromeTrace(const std::string& path)
+        {
+#if !WILLENGINE_TRACING
+            return false;
+#else
+            // Copy the rings under the lock, write the file after releasing it: a thread starting up
+            // mid-dump would otherwise wait on the disk to register its ring.
+            struct RingCopy
+            {
+                uint32_t threadIndex;
+                const char* threadName;
+                std::vector<Event> events;
+            };
+            std::vector<RingCopy> copies;
+            {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                copies.reserve(Registry().size());
+                for (const std::unique_ptr<ThreadRing>& ring : Registry()) {
+                    const uint64_t head = ring->head.load(std::memory_order_acquire);
+                    const uint64_t cleared = ring->clearedAt.load(std::memory_order_relaxed);
+                    uint64_t oldest = head > kRingCapacity ? head - kRingCapacity : 0;
+                    oldest = std::max(oldest, cleared);
+
+                    RingCopy& copy = copies.emplace_back(RingCopy{ ring->threadIndex, ring->threadName.load(std::memory_order_relaxed), {} });
+                    copy.events.reserve(size_t(head - oldest));
+                    for (uint64_t i = oldest; i < head; ++i) {
+                        copy.events.push_back(ring->events[i & (kRingCapacity - 1)]);
+                    }
+                    // The copy's loads must not move past the re-read of head below, or a slot overwritten
+                    // after that read could slip through as intact.
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    // Slots the writer got to while we were copying are torn: keep only what is still intact.
+                    // That includes slot `after` itself, which the writer may be filling right now.
+                    const uint64_t after = ring->head.load(std::memory_order_acquire);
+                    const uint64_t intactFrom = after + 1 > kRingCapacity ? after + 1 - kRingCapacity : 0;
+                    const size_t skip = intactFrom > oldest ? size_t(std::min(intactFrom - oldest, uint64_t(copy.events.size()))) : 0;
+                    copy.events.erase(copy.events.begin(), copy.events.begin() + skip);
+                }
+            }
+
+            std::ofstream out(path, std::ios::trunc);
+            if (!out) return false;
+            out << std::fixed << std::setprecision(3);
+            out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+            bool first = true;
+            for (const RingCopy& copy : copies) {
+                if (copy.threadName) {
+                    out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << copy.threadIndex << ",\"args\":{\"name\":\"";
+                    WriteEscaped(out, copy.threadName);
+                    out << "\"}}";
+                    first = false;
+                }
+                for (const Event& event : copy.events) {
+                    out << (first ? "" : ",\n") << "{\"ph\":\"X\",\"name\":\"";
+                    WriteEscaped(out, event.name);
+                    // Chrome traces are in microseconds, the decimals keep the nanoseconds.
+                    out << "\",\"pid\":1,\"tid\":" << copy.threadIndex
+                        << ",\"ts\":" << double(event.begin) / 1000.0 << ",\"dur\":" << double(event.end - event.begin) / 1000.0 << "}";
+                    first = false;
+                }
+            }
+            out << "\n]}\n";
+            return bool(out);
+#endif
+        }
+    }
+}
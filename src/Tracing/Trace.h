@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/*
+	Scoped timing zones, for looking at a frame in chrome://tracing or ui.perfetto.dev:
+
+		void PhysicsManager::Update(float dt)
+		{
+			WILLENGINE_TRACE_ZONE("Physics::Update");
+			...
+		}
+
+	Zones only exist when the engine is built with -DWILLENGINE_ENABLE_TRACING=ON; otherwise the macros
+	expand to nothing. Each thread writes into its own ring buffer without locking. When a ring is full the
+	oldest zones are overwritten, so a dump holds the last kRingCapacity zones of every thread.
+	Zone names must be string literals (or otherwise outlive the trace): only the pointer is stored.
+*/
+
+#if WILLENGINE_TRACING
+#define WILLENGINE_TRACE_CONCAT_INNER(a, b) a##b
+#define WILLENGINE_TRACE_CONCAT(a, b) WILLENGINE_TRACE_CONCAT_INNER(a, b)
+#define WILLENGINE_TRACE_ZONE(name) ::willengine::trace::Zone WILLENGINE_TRACE_CONCAT(traceZone_, __LINE__)(name)
+#define WILLENGINE_TRACE_THREAD(name) ::willengine::trace::SetThreadName(name)
+#else
+#define WILLENGINE_TRACE_ZONE(name) ((void)0)
+#define WILLENGINE_TRACE_THREAD(name) ((void)0)
+#endif
+
+namespace willengine
+{
+	namespace trace
+	{
+		constexpr size_t kRingCapacity = 1 << 16;	// zones per thread, a power of two
+
+		// Nanoseconds on a steady clock, since the first call.
+		uint64_t Now();
+
+		// Appends a finished zone to the calling thread's ring.
+		void Record(const char* name, uint64_t begin, uint64_t end);
+
+		// Shown instead of the thread id in the trace viewer.
+		void SetThreadName(const char* name);
+
+		// Writes every thread's zones as Chrome trace event JSON (also opened by ui.perfetto.dev).
+		// Safe to call while other threads keep recording. False if tracing is compiled out or the file can't be written.
+		bool WriteChromeTrace(const std::string& path);
+
+		// Forget every zone recorded so far.
+		void Clear();
+
+		class Zone
+		{
+		public:
+			explicit Zone(const char* name) : name(name), begin(Now()) {}
+			~Zone() { Record(name, begin, Now()); }
+			Zone(const Zone&) = delete;
+			Zone& operator=(const Zone&) = delete;
+
+		private:
+			const char* name;
+			uint64_t begin;
+		};
+	}
+}
@@ -4,6 +4,7 @@
 #include <glm/glm.hpp>
 #include <typeindex>
 #include <list>
+#include <tuple>
 #include <webgpu/webgpu.h>
 namespace willengine
 {
@@ -25,6 +26,7 @@ namespace willengine
 	typedef glm::vec4 vec4;
 	typedef glm::mat4 mat4;
 	typedef long entityID;
+	typedef int soundID;
 	typedef std::type_index ComponentIndex;
 
 
@@ -44,6 +46,7 @@ namespace willengine
 		bool isCollided;
 		BoxCollider() = default;
 		BoxCollider(const vec2& dimension_sizes, bool isCollided) : dimensionSizes(dimension_sizes), isCollided(isCollided = false){}
+		bool operator==(const BoxCollider&) const = default;
 	};
 
 	struct Sprite
@@ -54,6 +57,7 @@ namespace willengine
 
 		Sprite() = default;
 		Sprite(const std::string& img, float a, const vec2& s) : image(img), alpha(a), scale(s) {}
+		bool operator==(const Sprite&) const = default;
 	};
 
 	struct Health
@@ -62,6 +66,7 @@ namespace willengine
 
 		Health() = default;
 		Health(double p) : percent(p) {}
+		bool operator==(const Health&) const = default;
 	};
 	struct Transform : public vec2
 	{
@@ -75,10 +80,34 @@ namespace willengine
 		Velocity(const vec2& v) : vec2(v) {}
 	};
 
-	struct Gravity { double meters_per_second; };
+	struct Gravity
+	{
+		double meters_per_second;
+		bool operator==(const Gravity&) const = default;
+	};
 	struct Script 
 	{ 
 		std::string name;
+		bool operator==(const Script&) const = default;
 	};
 
+	// Every component type. Things that apply to all components (like the Lua ECS bindings)
+	// are generated from this list, so a new component only needs to be added here and named below.
+	using ComponentTypes = std::tuple<Transform, Sprite, Rigidbody, Velocity, Health, Gravity, Script, BoxCollider>;
+
+	template<typename T> inline constexpr bool kUnnamedComponent = false;
+	// Only the specializations below exist: a component in ComponentTypes without a name doesn't compile.
+	template<typename T> inline constexpr const char* ComponentName = [] {
+		static_assert(kUnnamedComponent<T>, "add a ComponentName specialization for this component");
+		return "";
+	}();
+	template<> inline constexpr const char* ComponentName<Transform> = "Transform";
+	template<> inline constexpr const char* ComponentName<Sprite> = "Sprite";
+	template<> inline constexpr const char* ComponentName<Rigidbody> = "Rigidbody";
+	template<> inline constexpr const char* ComponentName<Velocity> = "Velocity";
+	template<> inline constexpr const char* ComponentName<Health> = "Health";
+	template<> inline constexpr const char* ComponentName<Gravity> = "Gravity";
+	template<> inline constexpr const char* ComponentName<Script> = "Script";
+	template<> inline constexpr const char* ComponentName<BoxCollider> = "BoxCollider";
+
 }
\ No newline at end of file